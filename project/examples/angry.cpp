@@ -19,6 +19,7 @@ class Method: public ::Method{
     virtual ~Method(){}
     virtual void onDraw(Frame&frame,SceneParam const&sceneParam) override;
     virtual void onUpdate(float dt) override;
+    virtual bool isAnimated()const override{return true;}
     CommandBuffer           commandBuffer       ;///< command buffer
     GPUMemory               mem                 ;///< gpu memory
     float                   time = 0.f          ;///< elapsed time
@@ -122,6 +123,10 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg08 students when they see the izg project");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg08 students when they see the izg project");
+  registerShader("angryMethod::vertexShader",vertexShader);
+  registerShader("angryMethod::fragmentShader",fragmentShader);
+};
 
 }
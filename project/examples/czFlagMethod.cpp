@@ -19,6 +19,7 @@ class Method: public ::Method{
     virtual ~Method(){}
     virtual void onDraw(Frame&frame,SceneParam const&sceneParam) override;
     virtual void onUpdate(float dt) override;
+    virtual bool isAnimated()const override{return true;}
     CommandBuffer           commandBuffer       ;///< command buffer
     GPUMemory               mem                 ;///< gpu memory
     
@@ -88,15 +89,15 @@ Method::Method(MethodConstructionData const*){
       vertices.push_back({position,coord});
     }
 
-  for(uint32_t y=0;y<NY-1;++y)
-    for(uint32_t x=0;x<NX-1;++x){
-      indices.push_back((y+0)*NX+(x+0));
-      indices.push_back((y+0)*NX+(x+1));
-      indices.push_back((y+1)*NX+(x+0));
-      indices.push_back((y+1)*NX+(x+0));
-      indices.push_back((y+0)*NX+(x+1));
-      indices.push_back((y+1)*NX+(x+1));
+  // one triangle strip per row of quads, rows are separated by primitive restart index
+  // the upper vertex goes first, so triangles are counter-clockwise like the former triangle list
+  for(uint32_t y=0;y<NY-1;++y){
+    if(y)indices.push_back(0xffffffffu);
+    for(uint32_t x=0;x<NX;++x){
+      indices.push_back((y+1)*NX+x);
+      indices.push_back((y+0)*NX+x);
     }
+  }
 
   mem.buffers[0].data = vertices.data();
   mem.buffers[0].size = vertices.size() * sizeof(decltype(vertices)::value_type);
@@ -121,7 +122,10 @@ Method::Method(MethodConstructionData const*){
   vao.indexType     = IndexType::UINT32;
 
   pushClearCommand(commandBuffer,glm::vec4(.1,.1,.1,1));
-  pushDrawCommand (commandBuffer,(NX-1)*(NY-1)*6,0,vao);
+  pushDrawCommand (commandBuffer,(uint32_t)indices.size(),0,vao);
+  auto&draw = commandBuffer.commands[commandBuffer.nofCommands-1].data.drawCommand;
+  draw.topology         = Topology::TRIANGLE_STRIP;
+  draw.primitiveRestart = true;
 
 }
 
@@ -136,6 +140,10 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg07 czFlag");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg07 czFlag");
+  registerShader("czFlagMethod::vertexShader",vertexShader);
+  registerShader("czFlagMethod::fragmentShader",fragmentShader);
+};
 
 }
@@ -5,21 +5,113 @@
  * @author Tomáš Milet, imilet@fit.vutbr.cz
  */
 
+#include <framework/meshSimplifier.hpp>
 #include <framework/model.hpp>
 #include <framework/programContext.hpp>
 #include <student/drawModel.hpp>
 #include <examples/modelMethod.hpp>
 
+#include <algorithm>
+
 namespace modelMethod{
 
 /**
  * @brief Constructor
  */
-Method::Method(MethodConstructionData const*){
-  modelData.load(ProgramContext::get().args.modelFile);
-  model = modelData.getModel();
+Method::Method(MethodConstructionData const*mcd){
+  auto const&args = ProgramContext::get().args;
+  auto const*cd = dynamic_cast<ConstructionData const*>(mcd);
+  if(cd && cd->modelData){
+    modelData = cd->modelData;
+  }else{
+    modelData = std::make_shared<ModelData>();
+    modelData->load(args.modelFile,args.meshOptimization,args.meshLods,args.textureBudget != 0);
+    if(args.printProfile)
+      std::cerr << modelData->getLoadTimes() << std::endl;
+  }
+  model = modelData->getModel();
+  // streamed textures request levels by projected bounding spheres, meshes without levels of detail do not have them yet
+  if(args.textureBudget || (cd && cd->textureResidency))computeMeshBounds(model);
+
+  if(cd && cd->textureResidency)
+    textureResidency = cd->textureResidency;
+  else if(args.textureBudget){
+    textureResidency = std::make_shared<TextureResidency>();
+    textureResidency->init(modelData->getTextureSources(),(uint64_t)args.textureBudget<<20);
+  }
+  // streamed images are not decoded by the model, their mip tails (and opacity) come from the residency manager
+  if(textureResidency){
+    textureResidency->getTextures(residentTextures);
+    model.textures = residentTextures.textures;
+  }
+
+  // the scene graph is built once by the loader, commands are recorded by its linear scan
+  auto const&scene = modelData->getSceneGraph();
+  if(args.depthPrepass)
+    prepareModelDepthPrepass(mem,commandBuffer,model,scene);
+  else
+    prepareModel(mem,commandBuffer,model,scene);
+  drawMeshes = drawModelMeshes(model,scene,args.depthPrepass);
+
+  if(args.visibilityBuffer)submitFlags = submitFlags | SubmitFlags::VISIBILITY_BUFFER;
+  if(args.parallelShading )submitFlags = submitFlags | SubmitFlags::PARALLEL_SHADING ;
+  if(args.sortDraws       )submitFlags = submitFlags | SubmitFlags::SORT_DRAWS       ;
+}
+
+/**
+ * @brief This function updates view dependent state of every draw: level of detail and sort depth.
+ * The coarsest level whose simplification error projected to the screen is below maxLodPixelError is used.
+ * The error is projected at the nearest point of bounding sphere, the full mesh is used if the camera is inside it.
+ * Sort depth (SubmitFlags::SORT_DRAWS) is distance of the bounding sphere (or of the origin of the mesh if it has no bounding sphere).
+ * If textures are streamed, every draw requests mip level of its texture that matches projected diameter of the bounding sphere
+ * (the full resolution if the mesh has no bounding sphere).
+ * Fragment shaders that sample by read_texture with footprint request finer levels through sampling feedback.
+ *
+ * @param frame frame (its height is used)
+ * @param sceneParam scene parameters
+ */
+void Method::updateDraws(Frame const&frame,SceneParam const&sceneParam){
+  float const pixelScale = sceneParam.proj[1][1]*(float)frame.height*.5f;
+  uint32_t drawId = 0;
+  for(uint32_t c=0;c<commandBuffer.nofCommands;++c){
+    auto&cmd = commandBuffer.commands[c];
+    if(cmd.type != CommandType::DRAW)continue;
+    auto const&mesh = model.meshes[drawMeshes.at(drawId)];
+    auto const&matrix = mem.uniforms[drawModelUniforms(drawId)+DrawModelUniform::MODEL].m4;
+    auto&draw = cmd.data.drawCommand;
+    drawId++;
+    if(!(mesh.bounds.w > 0.f)){
+      draw.sortDepth = glm::length(glm::vec3(matrix[3])-sceneParam.camera);
+      if(textureResidency && mesh.diffuseTexture >= 0)textureResidency->request(mesh.diffuseTexture,0);
+      continue;
+    }
+
+    float const scale = std::max({glm::length(glm::vec3(matrix[0])),glm::length(glm::vec3(matrix[1])),glm::length(glm::vec3(matrix[2]))});
+    glm::vec3 const center = glm::vec3(matrix*glm::vec4(glm::vec3(mesh.bounds),1.f));
+    float const distance = glm::length(center-sceneParam.camera) - mesh.bounds.w*scale;
+    draw.sortDepth = distance;
+    if(textureResidency && mesh.diffuseTexture >= 0){
+      float const diameter = distance > 0.f?2.f*mesh.bounds.w*scale*pixelScale/distance:0.f;
+      textureResidency->request(mesh.diffuseTexture,textureResidency->requiredLevel(mesh.diffuseTexture,diameter));
+    }
+
+    uint32_t lod = 0;
+    if(distance > 0.f)
+      while(lod < mesh.nofLods && mesh.lods[lod].error*scale*pixelScale/distance <= maxLodPixelError)lod++;
 
-  prepareModel(mem,commandBuffer,model);
+    if(lod == 0){
+      draw.nofVertices       = mesh.nofIndices ;
+      draw.vao.indexBufferID = mesh.indexBufferID;
+      draw.vao.indexOffset   = mesh.indexOffset  ;
+      draw.vao.indexType     = mesh.indexType    ;
+    }else{
+      auto const&l = mesh.lods[lod-1];
+      draw.nofVertices       = l.nofIndices   ;
+      draw.vao.indexBufferID = l.indexBufferID;
+      draw.vao.indexOffset   = l.indexOffset  ;
+      draw.vao.indexType     = l.indexType    ;
+    }
+  }
 }
 
 
@@ -36,9 +128,20 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
   mem.uniforms[0].m4 = sceneParam.proj * sceneParam.view;
   mem.uniforms[1].v3 = sceneParam.light;
   mem.uniforms[2].v3 = sceneParam.camera;
-  gpu_execute(mem,commandBuffer);
+  updateDraws(frame,sceneParam);
+  if(textureResidency){
+    levelsChanged = textureResidency->update();
+    textureResidency->getTextures(residentTextures);
+    for(size_t i=0;i<residentTextures.textures.size();++i)
+      mem.textures[i] = residentTextures.textures[i];
+  }
+  gpu_execute(mem,commandBuffer,submitFlags);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg13 model loader");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg13 model loader");
+  registerShader("drawModel_vertexShader"  ,drawModel_vertexShader  );
+  registerShader("drawModel_fragmentShader",drawModel_fragmentShader);
+};
 
 }
@@ -2,9 +2,22 @@
 
 #include <framework/method.hpp>
 #include <framework/model.hpp>
+#include <framework/textureResidency.hpp>
+
+#include <memory>
+#include <vector>
 
 namespace modelMethod{
 
+/**
+ * @brief Construction data that allows to share one loaded model among several methods (e.g. rendering threads)
+ */
+class ConstructionData: public MethodConstructionData{
+  public:
+    std::shared_ptr<ModelData>modelData;///< already loaded model
+    std::shared_ptr<TextureResidency>textureResidency;///< streamed textures of the model (nullptr = every method streams its own textures if --texture-budget is set)
+};
+
 /**
  * @brief This class represents model visualizer
  */
@@ -16,10 +29,21 @@ class Method: public ::Method{
      */
     virtual ~Method(){};
     virtual void onDraw(Frame&frame,SceneParam const&sceneParam) override;
-    ModelData     modelData;
+    /**
+     * @brief The model has to be redrawn while streamed textures change their resident levels.
+     */
+    virtual bool isAnimated()const override{return levelsChanged;}
+    void updateDraws(Frame const&frame,SceneParam const&sceneParam);
+    std::shared_ptr<ModelData>modelData;
     Model         model;
     CommandBuffer commandBuffer;
     GPUMemory     mem;
+    std::vector<int32_t>drawMeshes;///< mesh of every draw command
+    float maxLodPixelError = 1.f;///< maximal simplification error of selected level of detail in pixels
+    SubmitFlags submitFlags = SubmitFlags::NONE;///< flags of gpu_execute
+    std::shared_ptr<TextureResidency>textureResidency;///< streamed textures within budget (--texture-budget), nullptr = textures are fully resident
+    ResidentTextures residentTextures;///< resident levels of streamed textures used by the last frame
+    bool levelsChanged = false;///< did the last update of streamed textures change their levels
 };
 
 }
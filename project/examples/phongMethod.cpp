@@ -25,6 +25,20 @@ class Method: public ::Method{
 
 
 //! [PhongMethod]
+/**
+ * @brief This function represents draw prologue of phong method.
+ * It computes projection*view matrix once per draw.
+ *
+ * @param drawConstants output - draw constants
+ * @param si shader interface
+ * @param drawID id of draw
+ */
+void prologue(Uniform*drawConstants,ShaderInterface const&si,uint32_t){
+  auto const&viewMatrix       = si.uniforms[0].m4;
+  auto const&projectionMatrix = si.uniforms[1].m4;
+  drawConstants[0].m4 = projectionMatrix*viewMatrix;
+}
+
 /**
  * @brief This function represents vertex shader of phong method.
  *
@@ -35,12 +49,12 @@ class Method: public ::Method{
 void vertexShader(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si){
   auto const pos = glm::vec4(inVertex.attributes[0].v3,1.f);
   auto const&nor = inVertex.attributes[1].v3;
-  auto const&viewMatrix       = si.uniforms[0].m4;
-  auto const&projectionMatrix = si.uniforms[1].m4;
 
-  auto mvp = projectionMatrix*viewMatrix;
-
-  outVertex.gl_Position = mvp * pos;
+  // programs without prologue multiply the matrices per vertex
+  if(si.drawConstants)
+    outVertex.gl_Position = si.drawConstants[0].m4 * pos;
+  else
+    outVertex.gl_Position = si.uniforms[1].m4 * si.uniforms[0].m4 * pos;
   outVertex.attributes[0].v3 = pos;
   outVertex.attributes[1].v3 = nor;
 }
@@ -105,6 +119,7 @@ Method::Method(MethodConstructionData const*){
   mem.buffers[1].size = sizeof(bunnyIndices);
   mem.programs[0].vertexShader   = vertexShader;
   mem.programs[0].fragmentShader = fragmentShader;
+  mem.programs[0].prologue       = prologue      ;
   mem.programs[0].vs2fs[0]       = AttributeType::VEC3;
   mem.programs[0].vs2fs[1]       = AttributeType::VEC3;
 
@@ -152,5 +167,10 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
 Method::~Method(){
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg10 phong bunny");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg10 phong bunny");
+  registerShader("phongMethod::vertexShader",vertexShader);
+  registerShader("phongMethod::fragmentShader",fragmentShader);
+  registerShader("phongMethod::prologue",prologue);
+};
 }
@@ -18,6 +18,7 @@ class Method: public ::Method{
     virtual ~Method();
     virtual void onDraw(Frame&frame,SceneParam const&sceneParam) override;
     virtual void onUpdate(float dt) override;
+    virtual bool isAnimated()const override{return true;}
     CommandBuffer commandBuffer;
     GPUMemory     mem          ;
     float         time = 0.f   ;///< elapsed time
@@ -122,6 +123,10 @@ void Method::onUpdate(float dt){
  */
 Method::~Method(){}
 
-EntryPoint main = [](){registerMethod<Method>("izg02 Rotating triangles");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg02 Rotating triangles");
+  registerShader("rotatingTriangles::vertexShader",vertexShader);
+  registerShader("rotatingTriangles::fragmentShader",fragmentShader);
+};
 
 }
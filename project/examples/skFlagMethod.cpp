@@ -176,6 +176,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
  */
 Method::~Method(){}
 
-EntryPoint main = [](){registerMethod<Method>("izg12 SKFlag");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg12 SKFlag");
+  registerShader("skFlagMethod::skFlag_VS",skFlag_VS);
+  registerShader("skFlagMethod::skFlag_FS",skFlag_FS);
+};
 
 }
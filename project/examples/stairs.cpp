@@ -19,6 +19,7 @@ class Method: public ::Method{
     virtual ~Method(){}
     virtual void onDraw(Frame&frame,SceneParam const&sceneParam) override;
     virtual void onUpdate(float dt) override;
+    virtual bool isAnimated()const override{return true;}
     CommandBuffer           commandBuffer       ;///< command buffer
     GPUMemory               mem                 ;///< gpu memory
     float                   time = 0.f          ;///< elapsed time
@@ -111,6 +112,10 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg09 stairs");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg09 stairs");
+  registerShader("stairsMethod::vertexShader",vertexShader);
+  registerShader("stairsMethod::fragmentShader",fragmentShader);
+};
 
 }
@@ -91,6 +91,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
  */
 Method::~Method(){}
 
-EntryPoint main = [](){registerMethod<Method>("izg11 Neutitschein 1863");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg11 Neutitschein 1863");
+  registerShader("texturedQuad::vertexShader",vertexShader);
+  registerShader("texturedQuad::fragmentShader",fragmentShader);
+};
 
 }
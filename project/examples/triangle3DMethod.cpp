@@ -95,6 +95,10 @@ void Method::onDraw(Frame&frame,SceneParam const&sceneParam){
  */
 Method::~Method(){}
 
-EntryPoint main = [](){registerMethod<Method>("izg05 triangle3D");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg05 triangle3D");
+  registerShader("triangle3DMethod::vertexShader",vertexShader);
+  registerShader("triangle3DMethod::fragmentShader",fragmentShader);
+};
 
 }
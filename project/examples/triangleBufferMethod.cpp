@@ -85,6 +85,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg06 triangleBuffer");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg06 triangleBuffer");
+  registerShader("triangleBufferMethod::vertexShader",vertexShader);
+  registerShader("triangleBufferMethod::fragmentShader",fragmentShader);
+};
 
 }
@@ -69,6 +69,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg03 Triangle Clip1");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg03 Triangle Clip1");
+  registerShader("triangleClip1Method::vertexShader",vertexShader);
+  registerShader("triangleClip1Method::fragmentShader",fragmentShader);
+};
 
 }
@@ -66,6 +66,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg04 Triangle Clip2");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg04 Triangle Clip2");
+  registerShader("triangleClip2Method::vertexShader",vertexShader);
+  registerShader("triangleClip2Method::fragmentShader",fragmentShader);
+};
 
 }
@@ -66,6 +66,10 @@ void Method::onDraw(Frame&frame,SceneParam const&){
   gpu_execute(mem,commandBuffer);
 }
 
-EntryPoint main = [](){registerMethod<Method>("izg01 triangle 2D");};
+EntryPoint main = [](){
+  registerMethod<Method>("izg01 triangle 2D");
+  registerShader("triangleMethod::vertexShader",vertexShader);
+  registerShader("triangleMethod::fragmentShader",fragmentShader);
+};
 
 }
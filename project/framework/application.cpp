@@ -36,13 +36,21 @@ Application::Application(int32_t width,int32_t height):Window(width,height,"izgP
   setCallback      (SDL_MOUSEMOTION        ,[&](SDL_Event const&event){mouseMotion(event);});
   setCallback      (SDL_KEYDOWN            ,[&](SDL_Event const&event){keyDown    (event);});
   defaultSceneParameters(orbitCamera,perspectiveCamera,light,width,height);
+  auto const&args = ProgramContext::get().args;
+  profiling = args.printProfile || !args.traceFile.empty();
+  captureNextFrame = !args.captureFile.empty();
+  onDemand = args.onDemand;
   timer.reset();
 }
 
 /**
  * @brief Destructor
  */
-Application::~Application(){}
+Application::~Application(){
+  if(!profiling)return;
+  auto const&args = ProgramContext::get().args;
+  profiler::report(profiler,args.printProfile,args.traceFile);
+}
 
     
 /**
@@ -69,9 +77,11 @@ void Application::createMethodIfItDoesNotExist(){
   if(mr.method)return;
   int w,h;
   SDL_GetWindowSize(getWindow(),&w,&h);
-  framebuffer = std::make_shared<Framebuffer>(w,h);
+  auto const&args = ProgramContext::get().args;
+  framebuffer = std::make_shared<Framebuffer>(w,h,args.msaa,args.tiledFramebuffer);
 
   mr.method = mr.methodFactories[mr.selectedMethod](&*mr.methodConstructData[mr.selectedMethod]);
+  frameValid = false;
   SDL_SetWindowTitle(getWindow(),mr.methodName.at(mr.selectedMethod).c_str());
 }
 
@@ -87,12 +97,45 @@ void Application::idle(){
   sceneParam.camera = glm::vec3(glm::inverse(sceneParam.view)*glm::vec4(0.f,0.f,0.f,1.f));
   sceneParam.light  = light;
 
+  // unchanged frame is only presented again
+  bool const redraw = !onDemand || !frameValid || captureNextFrame || mr.method->isAnimated() || sceneParam != lastSceneParam;
+  waitForEvents = onDemand && !redraw;
+  if(!redraw){
+    swap();
+    return;
+  }
+  lastSceneParam = sceneParam;
+  frameValid     = true;
+
   auto frame = framebuffer->getFrame();
-  mr.method->onDraw(frame,sceneParam);
+  if(captureNextFrame){
+    auto const&fileName = ProgramContext::get().args.captureFile;
+    captureNextFrame = false;
+    FrameCapture frameCapture;
+    {
+      ScopedFrameCapture scopedCapture(frameCapture);
+      drawFrame(frame,sceneParam);
+    }
+    frameCapture.save(fileName);
+    std::cerr << "storing frame capture (" << frameCapture.nofRecorded() << " submissions) to: \"" << fileName << "\"" << std::endl;
+  }else
+    drawFrame(frame,sceneParam);
 
   swap();
 }
 
+void Application::drawFrame(Frame&frame,SceneParam const&sceneParam){
+  auto&mr=ProgramContext::get().methods;
+  if(!profiling){
+    mr.method->onDraw(frame,sceneParam);
+    return;
+  }
+  profiler::ActiveProfiler activeProfiler(&profiler);
+  profiler.beginFrame();
+  mr.method->onDraw(frame,sceneParam);
+  profiler.endFrame();
+}
+
 void Application::resize(SDL_Event const&event){
   auto&mr=ProgramContext::get().methods;
   auto const width  = event.window.data1;
@@ -102,6 +145,7 @@ void Application::resize(SDL_Event const&event){
   if(mr.method){
     framebuffer->resize(event.window.data1,event.window.data2);
   }
+  frameValid = false;
   reInitRenderer();
 }
 
@@ -156,11 +200,21 @@ void Application::quit      (uint32_t key){
   running = false;
 }
 
+void Application::capture(uint32_t key){
+  if (key != SDLK_c)return;
+  if(ProgramContext::get().args.captureFile.empty()){
+    std::cerr << "frame capture file is not set (--capture)" << std::endl;
+    return;
+  }
+  captureNextFrame = true;
+}
+
 void Application::keyDown(SDL_Event const&event){
   auto key = event.key.keysym.sym;
   nextMethod(key);
   prevMethod(key);
   quit      (key);
+  capture   (key);
   float speed = 1;
   if(event.key.keysym.mod&KMOD_LSHIFT)speed = .1f;
   if(key == SDLK_a)this->orbitCamera.addXPosition(+speed);
@@ -172,6 +226,10 @@ void Application::keyDown(SDL_Event const&event){
 }
 
 void Application::swap(){
+  // resolve writes directly into the window surface
+  if(presentToSDLSurface(surface,framebuffer->getFrame()))return;
+
+  framebuffer->resolve();
   auto       frame = framebuffer->color.data();
   auto const w     = framebuffer->width;
   auto const h     = framebuffer->height; 
@@ -179,7 +237,31 @@ void Application::swap(){
   copyToSDLSurface(surface,frame,w,h);
 }
 
+bool presentToSDLSurface(SDL_Surface*surface,Frame const&frame){
+  auto const format = surface->format;
+  if(format->BytesPerPixel != 4)return false;
+  if((uint32_t)surface->w < frame.width || (uint32_t)surface->h < frame.height)return false;
+
+  PresentTarget target;
+  target.pixels     = (uint8_t*)surface->pixels;
+  target.pitch      = surface->pitch;
+  target.shifts[0]  = format->Rshift;
+  target.shifts[1]  = format->Gshift;
+  target.shifts[2]  = format->Bshift;
+  target.shifts[3]  = format->Ashift;
+  target.writeAlpha = format->Amask != 0;
+  target.flipY      = true;
+  gpu_present(frame,target);
+  return true;
+}
+
 void copyToSDLSurface(SDL_Surface*surface,uint8_t const*const frame,uint32_t width,uint32_t height){
+  Frame linear;
+  linear.color  = const_cast<uint8_t*>(frame);
+  linear.width  = width;
+  linear.height = height;
+  if(presentToSDLSurface(surface,linear))return;
+
   uint32_t const bitsPerByte    = 8;
   uint32_t const swizzleTable[] = {
       surface->format->Rshift / bitsPerByte,
@@ -198,4 +280,3 @@ void copyToSDLSurface(SDL_Surface*surface,uint8_t const*const frame,uint32_t wid
     }
   }
 }
-
@@ -14,7 +14,9 @@
 #include <BasicCamera/PerspectiveCamera.h>
 
 #include <student/gpu.hpp>
+#include <student/profiler.hpp>
 #include <framework/framebuffer.hpp>
+#include <framework/frameCapture.hpp>
 #include <framework/window.hpp>
 #include <framework/programContext.hpp>
 #include <framework/timer.hpp>
@@ -41,6 +43,8 @@ class Application: protected Window{
     void nextMethod(uint32_t key);
     void prevMethod(uint32_t key);
     void quit      (uint32_t key);
+    void capture   (uint32_t key);
+    void drawFrame (Frame&frame,SceneParam const&sceneParam);
     void createMethodIfItDoesNotExist();
     void swap();
 
@@ -53,6 +57,12 @@ class Application: protected Window{
     float                          orbitZoomSpeed    = 0.1f                     ;
 
     Timer<float>                   timer                                        ;
+    profiler::Profiler             profiler          {300}                      ;///< keeps the last 300 frames
+    bool                           profiling         = false                    ;
+    bool                           captureNextFrame  = false                    ;
+    bool                           onDemand          = false                    ;///< render only changed frames
+    bool                           frameValid        = false                    ;///< framebuffer contains frame of lastSceneParam
+    SceneParam                     lastSceneParam                               ;///< scene parameters of the frame in framebuffer
 
     std::shared_ptr<Framebuffer>framebuffer;///< framebuffer
 };
@@ -72,6 +82,16 @@ void defaultSceneParameters(
     glm::vec3&light,
     uint32_t width,uint32_t height);
 
+/**
+ * @brief This function writes frame into 32 bit SDL_Surface (resolve, channel order and flip in one pass)
+ *
+ * @param surface sdl surface
+ * @param frame frame (linear, multisampled or tiled)
+ *
+ * @return false if the surface format is not supported
+ */
+bool presentToSDLSurface(SDL_Surface*surface,Frame const&frame);
+
 /**
  * @brief This function swaps color buffer with SDL_Surface
  *
@@ -16,11 +16,45 @@ Arguments::Arguments(int argc,char const*argv[]){
   perfTests           = args->getu32   ("-f"          ,10,"number of frames that are tests during performance tests");
   mseThreshold        = args->getf32   ("--mse"       ,40,"mse threshold for image to image test");
   testToBreak         = args->geti32   ("--breakTest" ,-1,"this will forcefully break test with this number");
+  printProfile        = args->isPresent("--profile"   ,"prints per stage gpu profile (performance tests and application, needs cmake option IZG_PROFILING) and model load times");
+  traceFile           = args->gets     ("--trace"     ,""  ,"writes chrome trace_event json of gpu pipeline to this file (needs cmake option IZG_PROFILING)");
+  captureFile         = args->gets     ("--capture"   ,""  ,"application stores the first frame (and every frame after pressing c) into this capture file");
+  replayFile          = args->gets     ("--replay"    ,""  ,"replays capture file -f times without window");
+  replayImage         = args->gets     ("--replay-img",""  ,"stores the replayed frame into this png file");
+  msaa                = args->getu32   ("--msaa"      ,1   ,"number of samples per pixel of application and batch rendering framebuffer (1 or 4)");
+  onDemand            = args->isPresent("--on-demand","application renders only when scene parameters change or the method is animated, otherwise it waits for events");
+  tiledFramebuffer    =!args->isPresent("--no-tiling" ,"application and batch rendering render into linear framebuffer instead of tiled one");
+  bakeModel           = args->isPresent("--bake"      ,"bakes model (--model) into binary cache <model>.izgmodel that is used by next loads of the model");
+  auto const meshOpt  = args->gets     ("--optimize-meshes","none","reorders triangles and vertices of model meshes after loading: none, cache (vertex cache and fetch locality), overdraw (cache + outer triangles first)");
+  meshLods            = args->isPresent("--lods"      ,"generates levels of detail of model meshes after loading, model rendering selects them by distance");
+  depthPrepass        = args->isPresent("--depth-prepass","model rendering draws depth of opaque meshes first, the fragment shader is then executed once per visible pixel");
+  visibilityBuffer    = args->isPresent("--visibility-buffer","model rendering rasterizes opaque draws into visibility buffer and executes the fragment shader once per visible pixel");
+  parallelShading     = args->isPresent("--parallel-shading","visibility buffer (--visibility-buffer) is shaded by all cores");
+  sortDraws           = args->isPresent("--sort-draws","model rendering executes opaque draws sorted by texture and front-to-back");
+  textureBudget       = args->getu32   ("--texture-budget",0,"model rendering keeps at most this many MiB of texture mip levels resident, the least recently sampled textures are coarsened first, --batch gives every rendering thread this budget (0 = all textures are fully resident)");
+  batchDir            = args->gets     ("--batch"     ,""  ,"renders model (--model) without window into frame_NNNNNN.png files in this directory (it has to exist)");
+  batchPath           = args->gets     ("--batch-path",""  ,"camera path for --batch, every line contains: xAngle yAngle distance (degrees), default is turntable");
+  batchFrames         = args->getu32   ("--batch-frames",360,"number of turntable frames for --batch");
+  batchThreads        = args->getu32   ("--batch-threads",0,"number of rendering threads for --batch (0 = number of cores)");
+  batchIOThreads      = args->getu32   ("--batch-io-threads",0,"number of png encoding threads for --batch (0 = automatic)");
 
 
   auto printHelp  = args->isPresent("-h"    ,"prints help");
   printHelp |= args->isPresent("--help","prints help");
 
+  if(msaa != 1 && msaa != 4){
+    std::cerr << "--msaa supports only 1 or 4 samples" << std::endl;
+    stop = true;
+  }
+
+  if     (meshOpt == "none"    )meshOptimization = MeshOptimization::NONE        ;
+  else if(meshOpt == "cache"   )meshOptimization = MeshOptimization::VERTEX_CACHE;
+  else if(meshOpt == "overdraw")meshOptimization = MeshOptimization::OVERDRAW    ;
+  else{
+    std::cerr << "--optimize-meshes supports only none, cache or overdraw" << std::endl;
+    stop = true;
+  }
+
   if(printHelp || !args->validate()){
     std::cerr << args->toStr() << std::endl;
     stop = true;
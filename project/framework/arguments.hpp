@@ -8,6 +8,7 @@
 #pragma once
 
 #include <ArgumentViewer/ArgumentViewer.h>
+#include <framework/meshOptimizer.hpp>
 #include <iostream>
 #include <string>
 
@@ -47,5 +48,26 @@ class Arguments{
   bool     upToTest; ///< run tests up to selected test
   float    mseThreshold;///< threshold for image test
   int32_t  testToBreak;///< if you want to forcefully break test, set it to test id
+  bool        printProfile = false;///< should we print gpu profile summary
+  std::string traceFile         ;///< chrome trace output file (empty = no trace)
+  std::string captureFile       ;///< frame capture output file (empty = no capture)
+  std::string replayFile        ;///< frame capture that should be replayed (empty = no replay)
+  std::string replayImage       ;///< png file for replayed frame (empty = not stored)
+  uint32_t    msaa              ;///< number of samples per pixel (1 or 4)
+  bool        onDemand          ;///< should the application render only changed frames
+  bool        tiledFramebuffer  ;///< should application and batch rendering render into tiled framebuffer
+  bool        bakeModel         ;///< should the model be baked into binary cache
+  MeshOptimization meshOptimization = MeshOptimization::NONE;///< optimization of model meshes done after loading
+  bool        meshLods          ;///< generate levels of detail of model meshes after loading
+  bool        depthPrepass      ;///< model rendering draws depth of opaque meshes first and shades only visible fragments
+  bool        visibilityBuffer  ;///< model rendering uses visibility buffer (SubmitFlags::VISIBILITY_BUFFER)
+  bool        parallelShading   ;///< visibility buffer is shaded by all cores (SubmitFlags::PARALLEL_SHADING)
+  bool        sortDraws         ;///< model rendering sorts opaque draws by state and front-to-back (SubmitFlags::SORT_DRAWS)
+  uint32_t    textureBudget     ;///< budget of resident texture mip levels of model rendering in MiB (0 = no streaming)
+  std::string batchDir          ;///< output directory of batch rendering (empty = no batch rendering)
+  std::string batchPath         ;///< camera path of batch rendering (empty = turntable)
+  uint32_t    batchFrames       ;///< number of turntable frames of batch rendering
+  uint32_t    batchThreads      ;///< number of rendering threads of batch rendering (0 = number of cores)
+  uint32_t    batchIOThreads    ;///< number of png encoding threads of batch rendering (0 = automatic)
 };
 
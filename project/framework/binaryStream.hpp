@@ -0,0 +1,94 @@
+/*!
+ * @file
+ * @brief This file contains helpers for writing and reading simple binary files.
+ */
+
+#pragma once
+
+#include<cstdint>
+#include<cstring>
+#include<fstream>
+#include<stdexcept>
+#include<string>
+#include<type_traits>
+#include<vector>
+
+/**
+ * @brief This class serializes trivially copyable values into a byte array (host endianness).
+ */
+class BinaryWriter{
+  public:
+    template<typename T>
+    void write(T const&v){
+      static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be written");
+      writeBytes(&v,sizeof(T));
+    }
+    void writeBytes(void const*d,size_t size){
+      auto const*b = static_cast<uint8_t const*>(d);
+      data.insert(data.end(),b,b+size);
+    }
+    void writeString(std::string const&s){
+      write((uint32_t)s.size());
+      writeBytes(s.data(),s.size());
+    }
+    void save(std::string const&fileName)const{
+      std::ofstream file(fileName,std::ios::binary);
+      if(!file.is_open())throw std::runtime_error("cannot open file for writing: "+fileName);
+      file.write((char const*)data.data(),(std::streamsize)data.size());
+      if(!file.good())throw std::runtime_error("cannot write file: "+fileName);
+    }
+    std::vector<uint8_t>data;///< serialized data
+};
+
+/**
+ * @brief This class deserializes values from a byte array.
+ * It throws std::runtime_error if the data are truncated.
+ */
+class BinaryReader{
+  public:
+    BinaryReader(uint8_t const*d,size_t s):data(d),size(s){}
+    template<typename T>
+    T read(){
+      static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be read");
+      T res;
+      readBytes(&res,sizeof(T));
+      return res;
+    }
+    void readBytes(void*d,size_t n){
+      std::memcpy(d,skip(n),n);
+    }
+    uint8_t const*skip(size_t n){
+      if(n > size-offset)throw std::runtime_error("binary data are truncated");
+      auto const res = data+offset;
+      offset += n;
+      return res;
+    }
+    std::string readString(){
+      auto const n = read<uint32_t>();
+      auto const*s = skip(n);
+      return std::string((char const*)s,n);
+    }
+    bool atEnd()const{return offset == size;}
+    size_t        offset = 0      ;///< read position
+  private:
+    uint8_t const*data   = nullptr;
+    size_t        size   = 0      ;
+};
+
+/**
+ * @brief This function reads whole binary file.
+ *
+ * @param fileName file
+ *
+ * @return content of the file
+ */
+inline std::vector<uint8_t>readBinaryFile(std::string const&fileName){
+  std::ifstream file(fileName,std::ios::binary|std::ios::ate);
+  if(!file.is_open())throw std::runtime_error("cannot open file: "+fileName);
+  auto const size = (size_t)file.tellg();
+  std::vector<uint8_t>res(size);
+  file.seekg(0);
+  file.read((char*)res.data(),(std::streamsize)size);
+  if(!file.good())throw std::runtime_error("cannot read file: "+fileName);
+  return res;
+}
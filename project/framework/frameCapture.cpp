@@ -0,0 +1,278 @@
+#include<framework/frameCapture.hpp>
+#include<framework/programContext.hpp>
+#include<student/gpu.hpp>
+
+#include<cstring>
+#include<set>
+
+namespace{
+char     const captureMagic[8] = {'I','Z','G','C','A','P','0','1'};
+uint32_t const captureVersion  = 6;
+
+void recordFramebuffer(BinaryWriter&w,Frame const&frame,bool withContent){
+  w.write(frame.width );
+  w.write(frame.height);
+  w.write(frame.samples);
+  w.write((uint8_t)frame.tiled);
+  uint8_t const hasContent = withContent && frame.color && frame.depth;
+  w.write(hasContent);
+  if(!hasContent)return;
+  if(frame.tiled){
+    // color and depth of tiles are in one block
+    w.writeBytes(frame.color,gpu_tiledFrameSize(frame.width,frame.height,frame.samples));
+    return;
+  }
+  size_t const nofPixels = (size_t)frame.width*frame.height*frame.samples;
+  w.writeBytes(frame.color,nofPixels*4);
+  w.writeBytes(frame.depth,nofPixels*sizeof(float));
+}
+
+void recordBuffers(BinaryWriter&w,GPUMemory const&mem,CommandBuffer const&cb){
+  std::set<int32_t>ids;
+  for(uint32_t i=0;i<cb.nofCommands;++i){
+    auto const&cmd = cb.commands[i];
+    if(cmd.type != CommandType::DRAW)continue;
+    auto const&vao = cmd.data.drawCommand.vao;
+    if(vao.indexBufferID >= 0)ids.insert(vao.indexBufferID);
+    for(auto const&a:vao.vertexAttrib)
+      if(a.type != AttributeType::EMPTY && a.bufferID >= 0)ids.insert(a.bufferID);
+  }
+  w.write((uint32_t)ids.size());
+  for(auto const&id:ids){
+    if((uint32_t)id >= GPUMemory::maxBuffers)throw std::runtime_error("capture: draw references buffer out of range");
+    auto const&b = mem.buffers[id];
+    uint64_t const size = b.data?b.size:0;
+    w.write(id  );
+    w.write(size);
+    w.writeBytes(b.data,size);
+  }
+}
+
+void recordTextures(BinaryWriter&w,GPUMemory const&mem){
+  // textures are referenced by shaders through uniforms, so all of them are stored
+  uint32_t nofTextures = 0;
+  for(auto const&t:mem.textures)nofTextures += t.data != nullptr;
+  w.write(nofTextures);
+  for(uint32_t i=0;i<GPUMemory::maxTextures;++i){
+    auto const&t = mem.textures[i];
+    if(!t.data)continue;
+    w.write(i         );
+    w.write(t.width   );
+    w.write(t.height  );
+    w.write(t.channels);
+    w.writeBytes(t.data,(size_t)t.width*t.height*t.channels);
+  }
+}
+
+void recordUniforms(BinaryWriter&w,GPUMemory const&mem){
+  Uniform const defaultUniform;
+  std::vector<uint32_t>ids;
+  for(uint32_t i=0;i<GPUMemory::maxUniforms;++i)
+    if(std::memcmp(mem.uniforms+i,&defaultUniform,sizeof(Uniform)) != 0)ids.push_back(i);
+  w.write((uint32_t)ids.size());
+  for(auto const&i:ids){
+    w.write(i);
+    w.writeBytes(mem.uniforms+i,sizeof(Uniform));
+  }
+}
+
+std::string shaderName(std::string const&name,bool isSet,char const*kind){
+  if(isSet && name.empty())
+    throw std::runtime_error(std::string("capture: ")+kind+" is not registered (see registerShader)");
+  return name;
+}
+
+void recordPrograms(BinaryWriter&w,GPUMemory const&mem,CommandBuffer const&cb){
+  std::set<int32_t>ids;
+  for(uint32_t i=0;i<cb.nofCommands;++i)
+    if(cb.commands[i].type == CommandType::DRAW && cb.commands[i].data.drawCommand.programID >= 0)
+      ids.insert(cb.commands[i].data.drawCommand.programID);
+  auto const&shaders = ProgramContext::get().shaders;
+  w.write((uint32_t)ids.size());
+  for(auto const&id:ids){
+    if((uint32_t)id >= GPUMemory::maxPrograms)throw std::runtime_error("capture: draw references program out of range");
+    auto const&prg = mem.programs[id];
+    w.write(id);
+    w.writeString(shaderName(shaders.getName(prg.vertexShader  ),prg.vertexShader   != nullptr,"vertex shader"  ));
+    w.writeString(shaderName(shaders.getName(prg.fragmentShader),prg.fragmentShader != nullptr,"fragment shader"));
+    w.writeString(shaderName(shaders.getName(prg.prologue      ),prg.prologue       != nullptr,"draw prologue"  ));
+    for(auto const&a:prg.vs2fs)w.write((uint32_t)a);
+  }
+}
+
+void loadSubmit(BinaryReader&r,CapturedSubmit&s){
+  s.flags   = (SubmitFlags)r.read<uint32_t>();
+  s.width   = r.read<uint32_t>();
+  s.height  = r.read<uint32_t>();
+  s.samples = r.read<uint32_t>();
+  if(s.samples != 1 && s.samples != 4)throw std::runtime_error("capture: unsupported number of samples");
+  s.tiled   = r.read<uint8_t>();
+  if(r.read<uint8_t>()){
+    if(s.tiled){
+      s.color.resize(gpu_tiledFrameSize(s.width,s.height,s.samples));
+      r.readBytes(s.color.data(),s.color.size());
+    }else{
+      size_t const nofPixels = (size_t)s.width*s.height*s.samples;
+      s.color.resize(nofPixels*4);
+      s.depth.resize(nofPixels);
+      r.readBytes(s.color.data(),s.color.size());
+      r.readBytes(s.depth.data(),s.depth.size()*sizeof(float));
+    }
+  }
+
+  auto const nofBuffers = r.read<uint32_t>();
+  for(uint32_t i=0;i<nofBuffers;++i){
+    auto const id   = r.read<int32_t >();
+    auto const size = r.read<uint64_t>();
+    if((uint32_t)id >= GPUMemory::maxBuffers)throw std::runtime_error("capture: buffer id out of range");
+    s.storage.emplace_back(size);
+    r.readBytes(s.storage.back().data(),size);
+    s.mem->buffers[id].data = size?s.storage.back().data():nullptr;
+    s.mem->buffers[id].size = size;
+  }
+
+  auto const nofTextures = r.read<uint32_t>();
+  for(uint32_t i=0;i<nofTextures;++i){
+    auto const id = r.read<uint32_t>();
+    if(id >= GPUMemory::maxTextures)throw std::runtime_error("capture: texture id out of range");
+    auto&t    = s.mem->textures[id];
+    t.width    = r.read<uint32_t>();
+    t.height   = r.read<uint32_t>();
+    t.channels = r.read<uint32_t>();
+    s.storage.emplace_back((size_t)t.width*t.height*t.channels);
+    r.readBytes(s.storage.back().data(),s.storage.back().size());
+    t.data = s.storage.back().data();
+  }
+
+  auto const nofUniforms = r.read<uint32_t>();
+  for(uint32_t i=0;i<nofUniforms;++i){
+    auto const id = r.read<uint32_t>();
+    if(id >= GPUMemory::maxUniforms)throw std::runtime_error("capture: uniform id out of range");
+    r.readBytes(s.mem->uniforms+id,sizeof(Uniform));
+  }
+
+  auto const&shaders = ProgramContext::get().shaders;
+  auto const nofPrograms = r.read<uint32_t>();
+  for(uint32_t i=0;i<nofPrograms;++i){
+    auto const id = r.read<int32_t>();
+    if((uint32_t)id >= GPUMemory::maxPrograms)throw std::runtime_error("capture: program id out of range");
+    auto&prg = s.mem->programs[id];
+    auto const vsName = r.readString();
+    auto const fsName = r.readString();
+    auto const pName  = r.readString();
+    prg.vertexShader   = shaders.getVertexShader  (vsName);
+    prg.fragmentShader = shaders.getFragmentShader(fsName);
+    prg.prologue       = shaders.getDrawPrologue  (pName );
+    if(!vsName.empty() && !prg.vertexShader  )throw std::runtime_error("capture: unknown vertex shader: "  +vsName);
+    if(!fsName.empty() && !prg.fragmentShader)throw std::runtime_error("capture: unknown fragment shader: "+fsName);
+    if(!pName .empty() && !prg.prologue      )throw std::runtime_error("capture: unknown draw prologue: "  +pName );
+    for(auto&a:prg.vs2fs)a = (AttributeType)r.read<uint32_t>();
+  }
+
+  auto const nofCommands = r.read<uint32_t>();
+  if(nofCommands > CommandBuffer::maxCommands)throw std::runtime_error("capture: too many commands");
+  s.cb->nofCommands = nofCommands;
+  r.readBytes(s.cb->commands,sizeof(Command)*nofCommands);
+}
+
+}
+
+CapturedSubmit::CapturedSubmit():mem(std::make_unique<GPUMemory>()),cb(std::make_unique<CommandBuffer>()){}
+
+/**
+ * @brief This function records one submission.
+ * Data are copied immediately, so memory can be changed after this call.
+ *
+ * @param mem gpu memory
+ * @param cb command buffer
+ * @param flags submission flags, replay uses them too
+ */
+void FrameCapture::record(GPUMemory const&mem,CommandBuffer const&cb,SubmitFlags flags){
+  BinaryWriter w;
+  w.write((uint32_t)flags);
+  recordFramebuffer(w,mem.framebuffer,recorded.empty());
+  recordBuffers    (w,mem,cb);
+  recordTextures   (w,mem);
+  recordUniforms   (w,mem);
+  recordPrograms   (w,mem,cb);
+  w.write(cb.nofCommands);
+  w.writeBytes(cb.commands,sizeof(Command)*cb.nofCommands);
+  recorded.emplace_back(std::move(w));
+}
+
+size_t FrameCapture::nofRecorded()const{
+  return recorded.size();
+}
+
+/**
+ * @brief This function stores recorded submissions into file.
+ *
+ * @param fileName capture file
+ */
+void FrameCapture::save(std::string const&fileName)const{
+  BinaryWriter w;
+  w.writeBytes(captureMagic,sizeof(captureMagic));
+  w.write(captureVersion);
+  w.write((uint32_t)sizeof(Command));
+  w.write((uint32_t)sizeof(Uniform));
+  w.write((uint32_t)recorded.size());
+  for(auto const&s:recorded){
+    w.write((uint64_t)s.data.size());
+    w.writeBytes(s.data.data(),s.data.size());
+  }
+  w.save(fileName);
+}
+
+/**
+ * @brief This function loads capture file into submits.
+ * Shaders are resolved by names using ShaderRegistry.
+ *
+ * @param fileName capture file
+ */
+void FrameCapture::load(std::string const&fileName){
+  auto const data = readBinaryFile(fileName);
+  BinaryReader r(data.data(),data.size());
+  char magic[sizeof(captureMagic)];
+  r.readBytes(magic,sizeof(magic));
+  if(std::memcmp(magic,captureMagic,sizeof(magic)) != 0)throw std::runtime_error("not a frame capture: "+fileName);
+  if(r.read<uint32_t>() != captureVersion )throw std::runtime_error("unsupported frame capture version: "+fileName);
+  if(r.read<uint32_t>() != sizeof(Command))throw std::runtime_error("frame capture was made by incompatible build (Command layout): "+fileName);
+  if(r.read<uint32_t>() != sizeof(Uniform))throw std::runtime_error("frame capture was made by incompatible build (Uniform layout): "+fileName);
+  auto const nofSubmits = r.read<uint32_t>();
+  submits.clear();
+  submits.resize(nofSubmits);
+  for(auto&s:submits){
+    auto const size  = r.read<uint64_t>();
+    auto const start = r.offset;
+    loadSubmit(r,s);
+    if(r.offset - start != size)throw std::runtime_error("frame capture is corrupted: "+fileName);
+  }
+}
+
+ScopedFrameCapture::ScopedFrameCapture(FrameCapture&capture){
+  gpu_setSubmitHook([&capture](GPUMemory const&mem,CommandBuffer const&cb,SubmitFlags flags){capture.record(mem,cb,flags);});
+}
+
+ScopedFrameCapture::~ScopedFrameCapture(){
+  gpu_setSubmitHook(nullptr);
+}
+
+/**
+ * @brief This function executes loaded submissions into frame with their captured flags.
+ *
+ * @param submits loaded submissions
+ * @param frame output frame
+ * @param restoreFramebuffer should the captured framebuffer content be restored before the first submission
+ */
+void replaySubmits(std::vector<CapturedSubmit>&submits,Frame&frame,bool restoreFramebuffer){
+  if(submits.empty())return;
+  auto const&first = submits.front();
+  if(restoreFramebuffer && !first.color.empty() && first.width == frame.width && first.height == frame.height && first.samples == frame.samples && first.tiled == frame.tiled){
+    std::memcpy(frame.color,first.color.data(),first.color.size());
+    if(!first.tiled)std::memcpy(frame.depth,first.depth.data(),first.depth.size()*sizeof(float));
+  }
+  for(auto&s:submits){
+    s.mem->framebuffer = frame;
+    gpu_execute(*s.mem,*s.cb,s.flags);
+  }
+}
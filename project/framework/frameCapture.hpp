@@ -0,0 +1,63 @@
+/*!
+ * @file
+ * @brief This file contains binary capture of GPUMemory + CommandBuffer submissions.
+ *
+ * A capture holds every gpu_execute call of one frame: submission flags, referenced buffers, all textures,
+ * non default uniforms, used programs (shaders are stored by name, see ShaderRegistry)
+ * and the command buffer. The framebuffer content before the first submission is stored too.
+ * Commands are stored as raw structures, so a capture can only be replayed by a build
+ * with the same layout of Command (checked on load).
+ */
+
+#pragma once
+
+#include<memory>
+#include<string>
+#include<vector>
+
+#include<student/fwd.hpp>
+#include<student/gpu.hpp>
+#include<framework/binaryStream.hpp>
+
+/**
+ * @brief This class represents one replayable submission (gpu_execute call).
+ */
+class CapturedSubmit{
+  public:
+    CapturedSubmit();
+    std::vector<std::vector<uint8_t>>storage    ;///< owned data of buffers and textures
+    std::unique_ptr<GPUMemory>       mem        ;///< gpu memory (framebuffer is not set)
+    std::unique_ptr<CommandBuffer>   cb         ;///< command buffer
+    SubmitFlags                      flags    = SubmitFlags::NONE;///< flags of submission
+    uint32_t                         width    = 0;///< width of captured framebuffer
+    uint32_t                         height   = 0;///< height of captured framebuffer
+    uint32_t                         samples  = 1;///< number of samples per pixel of captured framebuffer
+    bool                             tiled    = false;///< was captured framebuffer tiled
+    std::vector<uint8_t>             color      ;///< framebuffer color before submission (only first submission, tiled: color and depth)
+    std::vector<float  >             depth      ;///< framebuffer depth before submission (only first submission)
+};
+
+/**
+ * @brief This class records submissions of a frame and stores/loads them.
+ */
+class FrameCapture{
+  public:
+    void record(GPUMemory const&mem,CommandBuffer const&cb,SubmitFlags flags = SubmitFlags::NONE);
+    void save(std::string const&fileName)const;
+    void load(std::string const&fileName);
+    size_t nofRecorded()const;
+    std::vector<CapturedSubmit>submits;///< loaded submissions
+  private:
+    std::vector<BinaryWriter>recorded;
+};
+
+/**
+ * @brief This class records all gpu_execute calls of the current thread while it exists.
+ */
+class ScopedFrameCapture{
+  public:
+    ScopedFrameCapture(FrameCapture&capture);
+    ~ScopedFrameCapture();
+};
+
+void replaySubmits(std::vector<CapturedSubmit>&submits,Frame&frame,bool restoreFramebuffer = true);
@@ -2,6 +2,7 @@
 
 #include <student/gpu.hpp>
 
+#include<algorithm>
 #include<memory>
 #include<vector>
 
@@ -11,7 +12,7 @@
  */
 class Framebuffer{
   public:
-    Framebuffer(uint32_t w = 500,uint32_t h = 500){
+    Framebuffer(uint32_t w = 500,uint32_t h = 500,uint32_t samples = 1,bool tiled = false):samples(samples),tiled(tiled){
       resize(w,h);
     }
     void resize(uint32_t w,uint32_t h){
@@ -22,12 +23,47 @@ class Framebuffer{
       color.resize((size_t)nofPixes*bytesPerPixel,0);
       for(size_t i=0;i<w*h;++i)color.at(i*bytesPerPixel+3)=255;
       depth.resize(nofPixes,1.f);
+      if(!hasRenderStorage())return;
+      // color and depth are 4 bytes per sample, storage is float vector because of alignment
+      auto const nofSamples = (size_t)nofPixes*samples;
+      renderStorage.resize(tiled?gpu_tiledFrameSize(w,h,samples)/sizeof(float):2*nofSamples);
+      clearRenderStorage();
     }
-    std::vector<uint8_t>color;
-    std::vector<float  >depth;
+    /**
+     * @brief This function sets the content to the initial state (black opaque color, depth 1).
+     */
+    void clear(){
+      std::fill(color.begin(),color.end(),(uint8_t)0);
+      for(size_t i=3;i<color.size();i+=4)color[i]=255;
+      std::fill(depth.begin(),depth.end(),1.f);
+      clearRenderStorage();
+    }
+    /**
+     * @brief This function resolves multisampled/tiled storage into color.
+     * It does nothing if the framebuffer is linear and single sampled.
+     */
+    void resolve(){
+      if(!hasRenderStorage())return;
+      Frame single;
+      single.color  = color.data();
+      single.width  = width;
+      single.height = height;
+      gpu_resolve(getFrame(),single);
+    }
+    std::vector<uint8_t>color;///< presented (resolved) color
+    std::vector<float  >depth;///< depth of linear single sampled framebuffer
+    std::vector<float  >renderStorage;///< color and depth used by rendering of multisampled/tiled framebuffer
     uint32_t width    = 0;
     uint32_t height   = 0;
     uint32_t channels = 4;
+    uint32_t samples  = 1;///< number of samples per pixel (1 or 4)
+    bool     tiled    = false;///< is render storage tiled?
+    /**
+     * @brief This function returns frame for rendering.
+     * Multisampled/tiled framebuffer returns its render storage, resolve() has to be called after rendering.
+     *
+     * @return frame
+     */
     Frame getFrame(){
       Frame frame;
       frame.color    = color.data();
@@ -35,6 +71,24 @@ class Framebuffer{
       frame.width    = width;
       frame.height   = height;
       frame.channels = channels;
+      frame.samples  = samples;
+      frame.tiled    = tiled;
+      if(!hasRenderStorage())return frame;
+      auto const base = reinterpret_cast<uint8_t*>(renderStorage.data());
+      frame.color = base;
+      // tiled: depth follows color of the first tile, linear: depth follows whole color buffer
+      frame.depth = reinterpret_cast<float*>(base+(tiled?(size_t)frameTileSize*frameTileSize:(size_t)width*height)*samples*4);
       return frame;
     }
+  private:
+    bool hasRenderStorage()const{
+      return samples > 1 || tiled;
+    }
+    void clearRenderStorage(){
+      if(!hasRenderStorage())return;
+      ClearCommand cmd;
+      cmd.color = glm::vec4(0.f,0.f,0.f,1.f);
+      cmd.depth = 1.f;
+      gpu_clear(getFrame(),cmd);
+    }
 };
@@ -3,9 +3,12 @@
 #include<framework/window.hpp>
 #include<framework/application.hpp>
 #include<framework/arguments.hpp>
+#include<framework/model.hpp>
 #include<framework/systemSpecific.hpp>
+#include<tests/batchRender.hpp>
 #include<tests/conformanceTests.hpp>
 #include<tests/performanceTest.hpp>
+#include<tests/replayCapture.hpp>
 #include<tests/takeScreenShot.hpp>
 
 int main(int argc,char const*argv[]){
@@ -22,7 +25,38 @@ int main(int argc,char const*argv[]){
     }
 
     if(args.runPerformanceTests){
-      runPerformanceTest(args.perfTests);
+      runPerformanceTest(args.perfTests,args.printProfile,args.traceFile);
+      return 0;
+    }
+
+    if(!args.replayFile.empty()){
+      replayCapture(args.replayFile,args.perfTests,args.printProfile,args.traceFile,args.replayImage);
+      return 0;
+    }
+
+    if(args.bakeModel){
+      ModelData model;
+      model.bake(args.modelFile,args.meshOptimization,args.meshLods);
+      std::cerr << model.getLoadTimes() << std::endl;
+      return 0;
+    }
+
+    if(!args.batchDir.empty()){
+      BatchSettings settings;
+      settings.modelFile     = args.modelFile;
+      settings.outputDir     = args.batchDir;
+      settings.cameraPath    = args.batchPath;
+      settings.width         = args.windowSize[0];
+      settings.height        = args.windowSize[1];
+      settings.nofFrames     = args.batchFrames;
+      settings.renderThreads = args.batchThreads;
+      settings.ioThreads     = args.batchIOThreads;
+      settings.samples       = args.msaa;
+      settings.tiled         = args.tiledFramebuffer;
+      settings.meshes        = args.meshOptimization;
+      settings.lods          = args.meshLods;
+      settings.textureBudget = args.textureBudget;
+      runBatchRender(settings);
       return 0;
     }
 
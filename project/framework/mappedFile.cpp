@@ -0,0 +1,77 @@
+#include<framework/mappedFile.hpp>
+
+#ifdef _WIN32
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#endif
+
+MappedFile::~MappedFile(){
+  close();
+}
+
+/**
+ * @brief This function maps file into memory.
+ *
+ * @param fileName file
+ *
+ * @return false if the file cannot be mapped (empty files cannot be mapped)
+ */
+bool MappedFile::open(std::string const&fileName){
+  close();
+#ifdef _WIN32
+  file = CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+  if(file == INVALID_HANDLE_VALUE){
+    file = nullptr;
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(file,&fileSize) || fileSize.QuadPart == 0){
+    close();
+    return false;
+  }
+  mapping = CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr);
+  if(!mapping){
+    close();
+    return false;
+  }
+  ptr = static_cast<uint8_t const*>(MapViewOfFile(mapping,FILE_MAP_READ,0,0,0));
+  if(!ptr){
+    close();
+    return false;
+  }
+  length = static_cast<size_t>(fileSize.QuadPart);
+#else
+  int const fd = ::open(fileName.c_str(),O_RDONLY);
+  if(fd < 0)return false;
+  struct stat st;
+  if(fstat(fd,&st) != 0 || st.st_size == 0){
+    ::close(fd);
+    return false;
+  }
+  void*const m = mmap(nullptr,static_cast<size_t>(st.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if(m == MAP_FAILED)return false;
+  ptr    = static_cast<uint8_t const*>(m);
+  length = static_cast<size_t>(st.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::close(){
+#ifdef _WIN32
+  if(ptr    )UnmapViewOfFile(ptr);
+  if(mapping)CloseHandle(mapping);
+  if(file   )CloseHandle(file);
+  mapping = nullptr;
+  file    = nullptr;
+#else
+  if(ptr)munmap(const_cast<uint8_t*>(ptr),length);
+#endif
+  ptr    = nullptr;
+  length = 0;
+}
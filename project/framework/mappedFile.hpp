@@ -0,0 +1,32 @@
+/*!
+ * @file
+ * @brief This file contains read only memory mapping of files.
+ */
+
+#pragma once
+
+#include<cstdint>
+#include<string>
+
+/**
+ * @brief This class maps a whole file into memory (read only).
+ * Pages are loaded by the operating system on first access.
+ */
+class MappedFile{
+  public:
+    MappedFile(){}
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile&operator=(MappedFile const&) = delete;
+    bool open(std::string const&fileName);
+    void close();
+    uint8_t const*data()const{return ptr   ;}///< mapped memory or nullptr
+    size_t        size()const{return length;}///< size of the file in bytes
+  private:
+    uint8_t const*ptr    = nullptr;
+    size_t        length = 0      ;
+#ifdef _WIN32
+    void*         file    = nullptr;
+    void*         mapping = nullptr;
+#endif
+};
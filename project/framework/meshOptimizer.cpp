@@ -0,0 +1,372 @@
+#include<framework/meshOptimizer.hpp>
+
+#include<algorithm>
+#include<cstring>
+#include<numeric>
+
+#include<glm/glm.hpp>
+
+namespace{
+
+/**
+ * @brief FIFO vertex cache simulated by timestamps (vertex is in cache if it was inserted less than cacheSize insertions ago).
+ */
+class VertexCache{
+  public:
+    VertexCache(uint32_t nofVertices):timestamps(nofVertices,0){}
+    bool contains(uint32_t v)const{return time - timestamps[v] <= meshOptimizerCacheSize;}
+    uint32_t age(uint32_t v)const{return time - timestamps[v];}
+    bool access(uint32_t v){
+      if(contains(v))return true;
+      timestamps[v] = time++;
+      return false;
+    }
+  private:
+    std::vector<uint32_t>timestamps;
+    uint32_t time = meshOptimizerCacheSize+1;
+};
+
+uint32_t attributeSize(VertexAttrib const&a){
+  return attributeTypeSize(a.type);
+}
+
+bool attributeFits(Model const&model,VertexAttrib const&a,uint32_t nofVertices){
+  if(a.type == AttributeType::EMPTY)return true;
+  if(a.bufferID < 0 || (size_t)a.bufferID >= model.buffers.size() || !attributeSize(a))return false;
+  auto const&b = model.buffers[a.bufferID];
+  return b.data && a.offset + a.stride*(nofVertices-1) + attributeSize(a) <= b.size;
+}
+
+uint8_t const*attributeData(Model const&model,VertexAttrib const&a,uint32_t vertex){
+  return static_cast<uint8_t const*>(model.buffers[a.bufferID].data) + a.offset + a.stride*vertex;
+}
+
+}
+
+/**
+ * @brief This function reads indices of mesh.
+ *
+ * @param model model
+ * @param mesh indexed mesh
+ * @param indices output indices
+ *
+ * @return false if the mesh is not indexed or its indices are outside of the buffer
+ */
+bool readMeshIndices(Model const&model,Mesh const&mesh,std::vector<uint32_t>&indices){
+  if(mesh.indexBufferID < 0 || (size_t)mesh.indexBufferID >= model.buffers.size())return false;
+  auto const&b = model.buffers[mesh.indexBufferID];
+  auto const indexSize = (uint64_t)mesh.indexType;
+  if(!b.data || mesh.indexOffset + indexSize*mesh.nofIndices > b.size)return false;
+  auto const*data = static_cast<uint8_t const*>(b.data) + mesh.indexOffset;
+  indices.resize(mesh.nofIndices);
+  for(uint32_t i=0;i<mesh.nofIndices;++i){
+    switch(mesh.indexType){
+      case IndexType::UINT8 :indices[i] = data[i];break;
+      case IndexType::UINT16:{uint16_t v;std::memcpy(&v,data+2*i,2);indices[i] = v;}break;
+      case IndexType::UINT32:{uint32_t v;std::memcpy(&v,data+4*i,4);indices[i] = v;}break;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief This function reads positions of first nofVertices vertices of mesh.
+ *
+ * @param model model
+ * @param mesh mesh with float position attribute (VEC3 or VEC4)
+ * @param nofVertices number of vertices
+ * @param positions output positions
+ *
+ * @return false if the positions are outside of the buffer or they are not 3 or 4 floats
+ */
+bool readMeshPositions(Model const&model,Mesh const&mesh,uint32_t nofVertices,std::vector<glm::vec3>&positions){
+  if((mesh.position.type != AttributeType::VEC3 && mesh.position.type != AttributeType::VEC4) || !attributeFits(model,mesh.position,nofVertices))return false;
+  positions.resize(nofVertices);
+  for(uint32_t v=0;v<nofVertices;++v)std::memcpy(&positions[v],attributeData(model,mesh.position,v),sizeof(glm::vec3));
+  return true;
+}
+
+/**
+ * @brief This function pads storage to multiple of alignment.
+ *
+ * @param storage data
+ * @param alignment alignment in bytes
+ */
+void alignStorage(std::vector<uint8_t>&storage,size_t alignment){
+  storage.resize((storage.size()+alignment-1)/alignment*alignment,0);
+}
+
+/**
+ * @brief This function reorders triangles for post-transform vertex cache (Tipsify, Sander et al. 2007).
+ * Triangles around a fanning vertex are emitted, the next fanning vertex is the one
+ * that stays in the cache after its remaining triangles are emitted.
+ *
+ * @param indices triangle list
+ * @param nofVertices number of vertices (all indices are smaller)
+ * @param clusters output (optional) - first triangle of every cluster, clusters are separated by cache flushes
+ *
+ * @return reordered triangle list
+ */
+std::vector<uint32_t>optimizeVertexCache(std::vector<uint32_t>const&indices,uint32_t nofVertices,std::vector<uint32_t>*clusters){
+  size_t const nofTriangles = indices.size()/3;
+
+  // vertex -> triangles
+  std::vector<uint32_t>live (nofVertices  ,0);
+  std::vector<uint32_t>start(nofVertices+1,0);
+  for(size_t i=0;i<nofTriangles*3;++i)live[indices[i]]++;
+  for(uint32_t v=0;v<nofVertices;++v)start[v+1] = start[v]+live[v];
+  std::vector<uint32_t>adjacency(nofTriangles*3);
+  std::vector<uint32_t>fill(start.begin(),start.end()-1);
+  for(size_t t=0;t<nofTriangles;++t)
+    for(size_t k=0;k<3;++k)adjacency[fill[indices[t*3+k]]++] = (uint32_t)t;
+
+  VertexCache          cache(nofVertices);
+  std::vector<bool    >emitted(nofTriangles,false);
+  std::vector<uint32_t>deadEnd;
+  std::vector<uint32_t>candidates;
+  std::vector<uint32_t>res;
+  res.reserve(nofTriangles*3);
+  uint32_t cursor = 0;
+
+  auto const skipDeadEnd = [&]()->int64_t{
+    while(!deadEnd.empty()){
+      auto const d = deadEnd.back();
+      deadEnd.pop_back();
+      if(live[d])return d;
+    }
+    for(;cursor<nofVertices;++cursor)
+      if(live[cursor])return cursor;
+    return -1;
+  };
+
+  if(clusters)clusters->assign(1,0);
+  int64_t fanning = skipDeadEnd();
+  while(fanning >= 0){
+    candidates.clear();
+    for(uint32_t a=start[fanning];a<start[fanning+1];++a){
+      auto const t = adjacency[a];
+      if(emitted[t])continue;
+      for(size_t k=0;k<3;++k){
+        auto const v = indices[t*3+k];
+        res.push_back(v);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        live[v]--;
+        cache.access(v);
+      }
+      emitted[t] = true;
+    }
+
+    // prefer vertex that will still be in cache after its fan is emitted
+    int64_t next     = -1;
+    int64_t priority = -1;
+    for(auto const v:candidates){
+      if(!live[v])continue;
+      int64_t p = 0;
+      if(cache.age(v)+2*live[v] <= meshOptimizerCacheSize)p = cache.age(v);
+      if(p > priority){
+        priority = p;
+        next     = v;
+      }
+    }
+    if(next < 0){
+      next = skipDeadEnd();
+      if(clusters && next >= 0 && clusters->back() != res.size()/3)clusters->push_back((uint32_t)(res.size()/3));
+    }
+    fanning = next;
+  }
+  return res;
+}
+
+/**
+ * @brief This function sorts clusters of triangles so the outer ones are drawn first (Sander et al. 2007).
+ * Clusters are split further at points where local ACMR is at least as good as ACMR of the whole mesh,
+ * so the vertex cache efficiency is mostly kept.
+ *
+ * @param indices triangle list ordered by optimizeVertexCache
+ * @param clusters clusters produced by optimizeVertexCache
+ * @param positions positions of vertices
+ */
+void optimizeOverdraw(std::vector<uint32_t>&indices,std::vector<uint32_t>const&clusters,std::vector<glm::vec3>const&positions){
+  uint32_t const nofTriangles    = (uint32_t)(indices.size()/3);
+  uint32_t const minClusterSize  = 16;
+  if(nofTriangles == 0)return;
+  float    const threshold       = computeACMR(indices,(uint32_t)positions.size());
+
+  // soft boundaries
+  std::vector<uint32_t>splits;
+  VertexCache cache((uint32_t)positions.size());
+  for(size_t c=0;c<clusters.size();++c){
+    uint32_t const end = c+1 < clusters.size()?clusters[c+1]:nofTriangles;
+    uint32_t first  = clusters[c];
+    uint32_t misses = 0;
+    splits.push_back(first);
+    for(uint32_t t=first;t<end;++t){
+      for(uint32_t k=0;k<3;++k)misses += !cache.access(indices[t*3+k]);
+      uint32_t const size = t+1-first;
+      if(t+1 < end && size >= minClusterSize && (float)misses <= threshold*(float)size){
+        first  = t+1;
+        misses = 0;
+        splits.push_back(first);
+      }
+    }
+  }
+
+  glm::vec3 meshCenter(0.f);
+  for(auto const&p:positions)meshCenter += p;
+  meshCenter /= (float)positions.size();
+
+  std::vector<float>sortKey(splits.size());
+  for(size_t c=0;c<splits.size();++c){
+    uint32_t const end = c+1 < splits.size()?splits[c+1]:nofTriangles;
+    glm::vec3 center(0.f);
+    glm::vec3 normal(0.f);
+    float     area = 0.f;
+    for(uint32_t t=splits[c];t<end;++t){
+      auto const&a = positions[indices[t*3+0]];
+      auto const&b = positions[indices[t*3+1]];
+      auto const&d = positions[indices[t*3+2]];
+      auto const n = glm::cross(b-a,d-a);
+      auto const w = glm::length(n);
+      center += (a+b+d)/3.f*w;
+      normal += n;
+      area   += w;
+    }
+    if(area > 0.f)center /= area;
+    auto const len = glm::length(normal);
+    sortKey[c] = len > 0.f?glm::dot(center-meshCenter,normal/len):0.f;
+  }
+
+  std::vector<uint32_t>order(splits.size());
+  std::iota(order.begin(),order.end(),0);
+  std::stable_sort(order.begin(),order.end(),[&](uint32_t a,uint32_t b){return sortKey[a] > sortKey[b];});
+
+  std::vector<uint32_t>res;
+  res.reserve(indices.size());
+  for(auto const c:order){
+    uint32_t const end = c+1 < splits.size()?splits[c+1]:nofTriangles;
+    res.insert(res.end(),indices.begin()+splits[c]*3,indices.begin()+end*3);
+  }
+  indices.swap(res);
+}
+
+/**
+ * @brief This function renumbers vertices in order of their first use.
+ *
+ * @param indices triangle list, it is rewritten to new vertex ids
+ * @param remap output - old vertex id of every new vertex id
+ *
+ * @return number of used vertices
+ */
+uint32_t optimizeVertexFetch(std::vector<uint32_t>&indices,std::vector<uint32_t>&remap){
+  uint32_t const unused = ~0u;
+  std::vector<uint32_t>newIds;
+  remap.clear();
+  for(auto&i:indices){
+    if(i >= newIds.size())newIds.resize(i+1,unused);
+    if(newIds[i] == unused){
+      newIds[i] = (uint32_t)remap.size();
+      remap.push_back(i);
+    }
+    i = newIds[i];
+  }
+  return (uint32_t)remap.size();
+}
+
+/**
+ * @brief This function computes average cache miss ratio (transformed vertices per triangle) of FIFO cache.
+ *
+ * @param indices triangle list
+ * @param nofVertices number of vertices
+ *
+ * @return ACMR (0.5 is optimal for large regular meshes, 3 is the worst)
+ */
+float computeACMR(std::vector<uint32_t>const&indices,uint32_t nofVertices){
+  if(indices.size() < 3)return 0.f;
+  VertexCache cache(nofVertices);
+  uint32_t misses = 0;
+  for(auto const i:indices)misses += !cache.access(i);
+  return (float)misses/(float)(indices.size()/3);
+}
+
+/**
+ * @brief This function optimizes all indexed meshes of model.
+ * Optimized meshes use one new buffer (stored in storage) with interleaved vertices and 16/32-bit indices,
+ * original buffers are kept, so buffer ids of other meshes do not change.
+ *
+ * @param model model, its meshes are rewritten and one buffer is added
+ * @param storage output - data of the new buffer, it has to live as long as the model
+ * @param optimization level of optimization
+ *
+ * @return statistics of optimized meshes
+ */
+MeshOptimizationStats optimizeMeshes(Model&model,std::vector<uint8_t>&storage,MeshOptimization optimization){
+  MeshOptimizationStats stats;
+  storage.clear();
+  if(optimization == MeshOptimization::NONE)return stats;
+  auto const bufferID = (int32_t)model.buffers.size();
+  std::vector<uint32_t>indices;
+  std::vector<uint32_t>clusters;
+  std::vector<uint32_t>remap;
+  std::vector<glm::vec3>positions;
+  for(auto&mesh:model.meshes){
+    if(mesh.position.type == AttributeType::EMPTY || mesh.nofIndices < 3 || mesh.nofIndices%3)continue;
+    if(!readMeshIndices(model,mesh,indices))continue;
+    uint32_t const nofVertices = *std::max_element(indices.begin(),indices.end())+1;
+    VertexAttrib*attribs[] = {&mesh.position,&mesh.normal,&mesh.texCoord};
+    if(!std::all_of(std::begin(attribs),std::end(attribs),[&](VertexAttrib const*a){return attributeFits(model,*a,nofVertices);}))continue;
+
+    auto const nofTriangles = (float)(indices.size()/3);
+    stats.acmrBefore += computeACMR(indices,nofVertices)*nofTriangles;
+    indices = optimizeVertexCache(indices,nofVertices,&clusters);
+    if(optimization == MeshOptimization::OVERDRAW && readMeshPositions(model,mesh,nofVertices,positions))
+      optimizeOverdraw(indices,clusters,positions);
+    stats.acmrAfter    += computeACMR(indices,nofVertices)*nofTriangles;
+    stats.nofTriangles += indices.size()/3;
+    auto const nofUsed = optimizeVertexFetch(indices,remap);
+
+    // interleaved vertices
+    uint32_t vertexSize = 0;
+    for(auto const*a:attribs)vertexSize += attributeSize(*a);
+    alignStorage(storage,16);
+    auto const vertexOffset = storage.size();
+    storage.resize(vertexOffset+(size_t)vertexSize*nofUsed);
+    uint32_t attribOffset = 0;
+    for(auto*a:attribs){
+      auto const size = attributeSize(*a);
+      if(!size)continue;
+      for(uint32_t v=0;v<nofUsed;++v)
+        std::memcpy(storage.data()+vertexOffset+(size_t)v*vertexSize+attribOffset,attributeData(model,*a,remap[v]),size);
+      a->bufferID = bufferID;
+      a->offset   = vertexOffset+attribOffset;
+      a->stride   = vertexSize;
+      attribOffset += size;
+    }
+
+    // indices
+    auto const indexType = nofUsed <= 0x10000?IndexType::UINT16:IndexType::UINT32;
+    alignStorage(storage,4);
+    auto const indexOffset = storage.size();
+    storage.resize(indexOffset+(size_t)indexType*indices.size());
+    for(size_t i=0;i<indices.size();++i){
+      if(indexType == IndexType::UINT16){
+        auto const v = (uint16_t)indices[i];
+        std::memcpy(storage.data()+indexOffset+2*i,&v,2);
+      }else
+        std::memcpy(storage.data()+indexOffset+4*i,&indices[i],4);
+    }
+    mesh.indexBufferID = bufferID;
+    mesh.indexOffset   = indexOffset;
+    mesh.indexType     = indexType;
+  }
+  if(stats.nofTriangles){
+    stats.acmrBefore /= (float)stats.nofTriangles;
+    stats.acmrAfter  /= (float)stats.nofTriangles;
+  }
+  if(storage.empty())return stats;
+  Buffer buffer;
+  buffer.data = storage.data();
+  buffer.size = storage.size();
+  model.buffers.push_back(buffer);
+  return stats;
+}
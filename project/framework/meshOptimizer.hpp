@@ -0,0 +1,45 @@
+/*!
+ * @file
+ * @brief This file contains load-time optimization of model meshes.
+ *
+ * Triangles of every indexed mesh are reordered for post-transform vertex cache locality (Tipsify)
+ * and optionally clusters of triangles are sorted to reduce overdraw.
+ * Vertices are then interleaved and stored in the order of their first use, so vertex pulling
+ * reads memory almost sequentially. Every triangle keeps its winding, only order of triangles changes.
+ */
+
+#pragma once
+
+#include<cstdint>
+#include<vector>
+
+#include<student/fwd.hpp>
+
+/**
+ * @brief Level of mesh optimization done after model loading.
+ */
+enum class MeshOptimization{
+  NONE         = 0,///< meshes are used as they are stored in the file
+  VERTEX_CACHE = 1,///< triangles are reordered for vertex cache, vertices are reordered to first use order
+  OVERDRAW     = 2,///< VERTEX_CACHE + clusters of triangles are sorted from outside to inside
+};
+
+/**
+ * @brief Average cache miss ratio of all optimized meshes (weighted by number of triangles).
+ */
+struct MeshOptimizationStats{
+  uint64_t nofTriangles = 0  ;///< number of triangles of optimized meshes
+  float    acmrBefore   = 0.f;///< ACMR of original triangle order
+  float    acmrAfter    = 0.f;///< ACMR of optimized triangle order
+};
+
+uint32_t const meshOptimizerCacheSize = 16;///< size of simulated post-transform vertex cache
+
+std::vector<uint32_t>optimizeVertexCache(std::vector<uint32_t>const&indices,uint32_t nofVertices,std::vector<uint32_t>*clusters = nullptr);
+void optimizeOverdraw(std::vector<uint32_t>&indices,std::vector<uint32_t>const&clusters,std::vector<glm::vec3>const&positions);
+uint32_t optimizeVertexFetch(std::vector<uint32_t>&indices,std::vector<uint32_t>&remap);
+float computeACMR(std::vector<uint32_t>const&indices,uint32_t nofVertices);
+bool readMeshIndices(Model const&model,Mesh const&mesh,std::vector<uint32_t>&indices);
+bool readMeshPositions(Model const&model,Mesh const&mesh,uint32_t nofVertices,std::vector<glm::vec3>&positions);
+void alignStorage(std::vector<uint8_t>&storage,size_t alignment);
+MeshOptimizationStats optimizeMeshes(Model&model,std::vector<uint8_t>&storage,MeshOptimization optimization);
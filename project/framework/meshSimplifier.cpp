@@ -0,0 +1,318 @@
+#include<framework/meshSimplifier.hpp>
+#include<framework/meshOptimizer.hpp>
+
+#include<algorithm>
+#include<cmath>
+#include<cstring>
+#include<unordered_map>
+
+#include<glm/glm.hpp>
+
+namespace{
+
+/**
+ * @brief Area weighted sum of squared distances to planes (symmetric 4x4 matrix).
+ */
+struct Quadric{
+  double a2 = 0,b2 = 0,c2 = 0,ab = 0,ac = 0,bc = 0,ad = 0,bd = 0,cd = 0,d2 = 0;
+  double weight = 0;
+  void addPlane(glm::dvec3 const&n,double d,double w){
+    a2 += w*n.x*n.x;b2 += w*n.y*n.y;c2 += w*n.z*n.z;
+    ab += w*n.x*n.y;ac += w*n.x*n.z;bc += w*n.y*n.z;
+    ad += w*n.x*d  ;bd += w*n.y*d  ;cd += w*n.z*d  ;
+    d2 += w*d*d;
+    weight += w;
+  }
+  void add(Quadric const&o){
+    a2 += o.a2;b2 += o.b2;c2 += o.c2;ab += o.ab;ac += o.ac;bc += o.bc;
+    ad += o.ad;bd += o.bd;cd += o.cd;d2 += o.d2;weight += o.weight;
+  }
+  /**
+   * @brief This function returns mean squared distance of point to planes.
+   */
+  double error(glm::vec3 const&p)const{
+    double const x = p.x,y = p.y,z = p.z;
+    double const e = a2*x*x + b2*y*y + c2*z*z + 2*(ab*x*y + ac*x*z + bc*y*z) + 2*(ad*x + bd*y + cd*z) + d2;
+    return weight > 0?std::max(e,0.)/weight:0.;
+  }
+};
+
+/**
+ * @brief Candidate collapse of vertex "from" onto vertex "to" (ids of welded positions).
+ */
+struct Collapse{
+  double   cost;
+  uint32_t from;
+  uint32_t to;
+  uint32_t toVertex;///< vertex id of "to" that replaces vertex of "from"
+};
+
+uint64_t edgeKey(uint32_t a,uint32_t b){
+  if(a > b)std::swap(a,b);
+  return (uint64_t)a << 32 | b;
+}
+
+/**
+ * @brief This function welds vertices with the same position.
+ *
+ * @param positions positions of vertices
+ * @param welded output - id of welded position of every vertex
+ *
+ * @return number of welded positions
+ */
+uint32_t weldPositions(std::vector<glm::vec3>const&positions,std::vector<uint32_t>&welded){
+  struct Hash{
+    size_t operator()(glm::vec3 const&p)const{
+      uint32_t b[3];
+      std::memcpy(b,&p,sizeof(b));
+      return (size_t)b[0]*73856093u ^ (size_t)b[1]*19349663u ^ (size_t)b[2]*83492791u;
+    }
+  };
+  std::unordered_map<glm::vec3,uint32_t,Hash>ids;
+  welded.resize(positions.size());
+  for(size_t v=0;v<positions.size();++v){
+    auto const it = ids.emplace(positions[v],(uint32_t)ids.size()).first;
+    welded[v] = it->second;
+  }
+  return (uint32_t)ids.size();
+}
+
+/**
+ * @brief This function computes bounding sphere of indexed vertices (centered in their bounding box).
+ *
+ * @param indices indices, at least one
+ * @param positions positions of vertices
+ *
+ * @return center and radius
+ */
+glm::vec4 boundingSphere(std::vector<uint32_t>const&indices,std::vector<glm::vec3>const&positions){
+  glm::vec3 minCorner = positions[indices[0]];
+  glm::vec3 maxCorner = minCorner;
+  for(auto const i:indices){
+    minCorner = glm::min(minCorner,positions[i]);
+    maxCorner = glm::max(maxCorner,positions[i]);
+  }
+  glm::vec3 const center = (minCorner+maxCorner)*.5f;
+  float radius = 0.f;
+  for(auto const i:indices)radius = std::max(radius,glm::length(positions[i]-center));
+  return glm::vec4(center,radius);
+}
+
+}
+
+/**
+ * @brief This function simplifies triangle mesh by greedy edge collapses ordered by quadric error.
+ * Every pass sorts all candidate collapses and applies independent ones, passes are repeated
+ * until the target is reached or no collapse is cheaper than maxError.
+ * Collapses that flip a triangle are rejected.
+ *
+ * @param indices triangle list
+ * @param positions positions of vertices
+ * @param targetIndices desired number of indices
+ * @param maxError maximal distance (model space) of simplified surface from the original one
+ * @param resultError output (optional) - error of the simplified mesh
+ *
+ * @return simplified triangle list (it uses original vertices)
+ */
+std::vector<uint32_t>simplifyMesh(std::vector<uint32_t>const&indices,std::vector<glm::vec3>const&positions,size_t targetIndices,float maxError,float*resultError){
+  std::vector<uint32_t>res(indices.begin(),indices.begin()+indices.size()/3*3);
+  if(resultError)*resultError = 0.f;
+
+  std::vector<uint32_t>welded;
+  auto const nofWelded = weldPositions(positions,welded);
+  std::vector<glm::vec3>weldedPosition(nofWelded);
+  for(size_t v=0;v<positions.size();++v)weldedPosition[welded[v]] = positions[v];
+
+  // vertices on borders and seams stay where they are
+  std::vector<uint32_t>vertexOf(nofWelded,~0u);
+  std::vector<bool    >locked  (nofWelded,false);
+  std::unordered_map<uint64_t,uint32_t>edgeUse;
+  std::vector<Quadric>quadrics(nofWelded);
+  for(size_t t=0;t<res.size();t+=3){
+    for(size_t k=0;k<3;++k){
+      auto const v = res[t+k];
+      auto const w = welded[v];
+      if(vertexOf[w] != ~0u && vertexOf[w] != v)locked[w] = true;
+      vertexOf[w] = v;
+      edgeUse[edgeKey(w,welded[res[t+(k+1)%3]])]++;
+    }
+    glm::dvec3 const a = positions[res[t+0]];
+    glm::dvec3 const b = positions[res[t+1]];
+    glm::dvec3 const c = positions[res[t+2]];
+    auto       const n = glm::cross(b-a,c-a);
+    auto       const l = glm::length(n);
+    if(l <= 0.)continue;
+    for(size_t k=0;k<3;++k)quadrics[welded[res[t+k]]].addPlane(n/l,-glm::dot(n/l,a),l*.5);
+  }
+  for(auto const&e:edgeUse)
+    if(e.second == 1){
+      locked[e.first >> 32        ] = true;
+      locked[e.first & 0xffffffffu] = true;
+    }
+
+  double const maxCost = (double)maxError*maxError;
+  double       error   = 0.;
+  std::vector<uint32_t>start;
+  std::vector<uint32_t>adjacency;
+  std::vector<Collapse>collapses;
+  std::vector<bool    >touched;
+  std::vector<uint32_t>moveTo(positions.size());
+
+  while(res.size() > targetIndices){
+    size_t const nofTriangles = res.size()/3;
+
+    // welded position -> triangles
+    start.assign(nofWelded+1,0);
+    for(auto const v:res)start[welded[v]+1]++;
+    for(uint32_t w=0;w<nofWelded;++w)start[w+1] += start[w];
+    adjacency.resize(res.size());
+    std::vector<uint32_t>fill(start.begin(),start.end()-1);
+    for(size_t i=0;i<res.size();++i)adjacency[fill[welded[res[i]]]++] = (uint32_t)(i/3);
+
+    collapses.clear();
+    for(size_t t=0;t<nofTriangles;++t)
+      for(size_t k=0;k<3;++k){
+        auto const v0 = res[t*3+k      ];
+        auto const v1 = res[t*3+(k+1)%3];
+        auto const w0 = welded[v0];
+        auto const w1 = welded[v1];
+        if(w0 == w1)continue;
+        for(int dir=0;dir<2;++dir){
+          auto const from = dir?w1:w0;
+          auto const to   = dir?w0:w1;
+          if(locked[from])continue;
+          Quadric q = quadrics[from];
+          q.add(quadrics[to]);
+          collapses.push_back({q.error(weldedPosition[to]),from,to,dir?v0:v1});
+        }
+      }
+    std::sort(collapses.begin(),collapses.end(),[](Collapse const&a,Collapse const&b){return a.cost < b.cost;});
+
+    touched.assign(nofWelded,false);
+    for(size_t v=0;v<moveTo.size();++v)moveTo[v] = (uint32_t)v;
+    size_t removed = 0;
+    size_t applied = 0;
+    for(auto const&c:collapses){
+      if(c.cost > maxCost || (nofTriangles-removed)*3 <= targetIndices)break;
+      if(touched[c.from] || touched[c.to])continue;
+
+      // reject collapse that flips a triangle around "from"
+      bool flip = false;
+      size_t shared = 0;
+      for(uint32_t a=start[c.from];a<start[c.from+1] && !flip;++a){
+        auto const t = adjacency[a];
+        glm::vec3 p[3];
+        bool hasTo = false;
+        for(size_t k=0;k<3;++k){
+          p[k]   = weldedPosition[welded[res[t*3+k]]];
+          hasTo |= welded[res[t*3+k]] == c.to;
+        }
+        if(hasTo){
+          shared++;
+          continue;
+        }
+        auto const n0 = glm::cross(p[1]-p[0],p[2]-p[0]);
+        for(size_t k=0;k<3;++k)
+          if(welded[res[t*3+k]] == c.from)p[k] = weldedPosition[c.to];
+        auto const n1 = glm::cross(p[1]-p[0],p[2]-p[0]);
+        flip = glm::dot(n0,n1) <= 0.f;
+      }
+      if(flip)continue;
+
+      quadrics[c.to].add(quadrics[c.from]);
+      moveTo[vertexOf[c.from]] = c.toVertex;
+      error = std::max(error,c.cost);
+      // triangles around "from" change, so their vertices must not be used by other collapses of this pass
+      for(uint32_t a=start[c.from];a<start[c.from+1];++a)
+        for(size_t k=0;k<3;++k)touched[welded[res[adjacency[a]*3+k]]] = true;
+      removed += shared;
+      applied++;
+    }
+    if(!applied)break;
+
+    size_t out = 0;
+    for(size_t t=0;t<res.size();t+=3){
+      uint32_t const v[3] = {moveTo[res[t]],moveTo[res[t+1]],moveTo[res[t+2]]};
+      if(welded[v[0]] == welded[v[1]] || welded[v[1]] == welded[v[2]] || welded[v[0]] == welded[v[2]])continue;
+      res[out++] = v[0];
+      res[out++] = v[1];
+      res[out++] = v[2];
+    }
+    res.resize(out);
+  }
+  if(resultError)*resultError = (float)std::sqrt(error);
+  return res;
+}
+
+/**
+ * @brief This function generates levels of detail of all indexed meshes of model.
+ * Every level has half of triangles of the previous one, simplification error is limited by size of the mesh.
+ * Indices of all levels are stored in one new buffer, vertices of meshes are shared.
+ *
+ * @param model model, levels of detail and bounding spheres are written into its meshes and one buffer is added
+ * @param storage output - data of the new buffer, it has to live as long as the model
+ */
+void generateMeshLods(Model&model,std::vector<uint8_t>&storage){
+  float const maxRelativeError = 0.05f;///< maximal error relative to radius of bounding sphere
+  float const minReduction     = 0.8f ;///< level is not stored if it does not remove at least 20 % of triangles
+
+  storage.clear();
+  auto const bufferID = (int32_t)model.buffers.size();
+  std::vector<uint32_t>indices;
+  std::vector<glm::vec3>positions;
+  for(auto&mesh:model.meshes){
+    mesh.nofLods = 0;
+    if(mesh.nofIndices < 3 || !readMeshIndices(model,mesh,indices))continue;
+    uint32_t const nofVertices = *std::max_element(indices.begin(),indices.end())+1;
+    if(!readMeshPositions(model,mesh,nofVertices,positions))continue;
+
+    mesh.bounds = boundingSphere(indices,positions);
+    float const radius = mesh.bounds.w;
+
+    auto lod = indices;
+    for(uint32_t l=0;l+1<maxMeshLods;++l){
+      float error = 0.f;
+      auto simplified = simplifyMesh(lod,positions,lod.size()/6*3,radius*maxRelativeError,&error);
+      if(simplified.size() < 3 || (float)simplified.size() > minReduction*(float)lod.size())break;
+      simplified = optimizeVertexCache(simplified,nofVertices);
+
+      auto&meshLod = mesh.lods[mesh.nofLods++];
+      meshLod.indexBufferID = bufferID;
+      meshLod.indexType     = nofVertices <= 0x10000?IndexType::UINT16:IndexType::UINT32;
+      meshLod.nofIndices    = (uint32_t)simplified.size();
+      meshLod.error         = std::max(error,l?mesh.lods[l-1].error:0.f);
+      alignStorage(storage,4);
+      meshLod.indexOffset   = storage.size();
+      storage.resize(storage.size()+(size_t)meshLod.indexType*simplified.size());
+      for(size_t i=0;i<simplified.size();++i){
+        if(meshLod.indexType == IndexType::UINT16){
+          auto const v = (uint16_t)simplified[i];
+          std::memcpy(storage.data()+meshLod.indexOffset+2*i,&v,2);
+        }else
+          std::memcpy(storage.data()+meshLod.indexOffset+4*i,&simplified[i],4);
+      }
+      lod.swap(simplified);
+    }
+  }
+  if(storage.empty())return;
+  Buffer buffer;
+  buffer.data = storage.data();
+  buffer.size = storage.size();
+  model.buffers.push_back(buffer);
+}
+
+/**
+ * @brief This function computes bounding spheres of indexed meshes that do not have them (see generateMeshLods).
+ *
+ * @param model model, bounding spheres are written into its meshes
+ */
+void computeMeshBounds(Model&model){
+  std::vector<uint32_t>indices;
+  std::vector<glm::vec3>positions;
+  for(auto&mesh:model.meshes){
+    if(mesh.bounds.w > 0.f || mesh.nofIndices < 3 || !readMeshIndices(model,mesh,indices))continue;
+    uint32_t const nofVertices = *std::max_element(indices.begin(),indices.end())+1;
+    if(!readMeshPositions(model,mesh,nofVertices,positions))continue;
+    mesh.bounds = boundingSphere(indices,positions);
+  }
+}
@@ -0,0 +1,19 @@
+/*!
+ * @file
+ * @brief This file contains quadric error mesh simplification and generation of levels of detail.
+ *
+ * Simplification collapses edges onto their existing end vertices (Garland-Heckbert quadrics),
+ * so all levels of detail share vertices of the original mesh and differ only in indices.
+ * Vertices on borders and attribute seams (several vertices with the same position) are never moved.
+ */
+
+#pragma once
+
+#include<cstdint>
+#include<vector>
+
+#include<student/fwd.hpp>
+
+std::vector<uint32_t>simplifyMesh(std::vector<uint32_t>const&indices,std::vector<glm::vec3>const&positions,size_t targetIndices,float maxError,float*resultError = nullptr);
+void generateMeshLods(Model&model,std::vector<uint8_t>&storage);
+void computeMeshBounds(Model&model);
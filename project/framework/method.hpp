@@ -26,6 +26,14 @@ struct SceneParam{
   glm::vec3 camera;
 };
 
+inline bool operator==(SceneParam const&a,SceneParam const&b){
+  return a.proj == b.proj && a.view == b.view && a.light == b.light && a.camera == b.camera;
+}
+
+inline bool operator!=(SceneParam const&a,SceneParam const&b){
+  return !(a == b);
+}
+
 /**
  * @brief This class represents rendering method.
  */
@@ -54,5 +62,12 @@ class Method{
      * @param dt delta time - time between frames
      */
     virtual void onUpdate(float dt){(void)dt;}
+    /**
+     * @brief This function returns true if the rendered image changes with time (onUpdate).
+     * Frames of not animated methods are rendered only when scene parameters change (--on-demand).
+     *
+     * @return true if the method is animated
+     */
+    virtual bool isAnimated()const{return false;}
 };
 
@@ -1,10 +1,21 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <thread>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <framework/mappedFile.hpp>
 #include <framework/model.hpp>
+#include <framework/modelCache.hpp>
+#include <framework/meshSimplifier.hpp>
+#include <framework/timer.hpp>
+#include <libs/json/json.hpp>
 #include <libs/tiny_gltf/tiny_gltf.h>
+#include <libs/stb_image/stb_image.h>
 
 namespace tests{
 void printModel(Model const&model);
@@ -36,38 +47,419 @@ std::string accesstorType2Str(int i){
   return "unknow";
 }
 
+namespace{
+
+/**
+ * @brief Encoded image that waits for decoding.
+ */
+struct EncodedImage{
+  tinygltf::Image*image = nullptr;///< output image
+  uint8_t const*  data  = nullptr;///< encoded bytes (png, jpg, ...)
+  size_t          size  = 0      ;///< number of encoded bytes
+};
+
+/**
+ * @brief This function decodes one image the same way as the default tinygltf image loader (RGBA, 8 or 16 bits).
+ *
+ * @param image output image
+ * @param data encoded bytes
+ * @param size number of encoded bytes
+ *
+ * @return false if the image cannot be decoded
+ */
+bool decodeImage(tinygltf::Image&image,uint8_t const*data,size_t size){
+  int w = 0,h = 0,comp = 0;
+  int bits      = 8;
+  int pixelType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+  uint8_t*pixels = nullptr;
+  if(stbi_is_16_bit_from_memory(data,(int)size)){
+    pixels = reinterpret_cast<uint8_t*>(stbi_load_16_from_memory(data,(int)size,&w,&h,&comp,4));
+    if(pixels){
+      bits      = 16;
+      pixelType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+    }
+  }
+  if(!pixels)pixels = stbi_load_from_memory(data,(int)size,&w,&h,&comp,4);
+  if(!pixels)return false;
+  std::vector<unsigned char>decoded(pixels,pixels+(size_t)w*h*4*(bits/8));
+  stbi_image_free(pixels);
+  image.width      = w;
+  image.height     = h;
+  image.component  = 4;
+  image.bits       = bits;
+  image.pixel_type = pixelType;
+  image.image.swap(decoded);
+  return true;
+}
+
+/**
+ * @brief This function decodes images in parallel.
+ * stb_image does not have global state (except vertical flip that is not used), so images can be decoded concurrently.
+ *
+ * @param images images to decode
+ * @param nofThreads output - number of used threads
+ *
+ * @return false if any image cannot be decoded
+ */
+bool decodeImages(std::vector<EncodedImage>const&images,uint32_t&nofThreads){
+  nofThreads = 0;
+  if(images.empty())return true;
+  auto hwThreads = std::thread::hardware_concurrency();
+  if(hwThreads == 0)hwThreads = 4;
+  nofThreads = std::min<uint32_t>(hwThreads,(uint32_t)images.size());
+
+  std::atomic<size_t>next  {0   };
+  std::atomic<bool  >success{true};
+  auto const worker = [&](){
+    for(size_t i = next++;i < images.size();i = next++)
+      if(!decodeImage(*images[i].image,images[i].data,images[i].size))success = false;
+  };
+  std::vector<std::thread>threads;
+  for(uint32_t t=1;t<nofThreads;++t)threads.emplace_back(worker);
+  worker();
+  for(auto&t:threads)t.join();
+  return success;
+}
+
+/**
+ * @brief Image loader for tinygltf that only stores encoded bytes into the image.
+ * Images are decoded in parallel after the whole file is parsed.
+ */
+bool storeEncodedImage(tinygltf::Image*image,int,std::string*,std::string*,int,int,unsigned char const*bytes,int size,void*){
+  image->image.assign(bytes,bytes+size);
+  return true;
+}
+
+}
+
 class ModelDataImpl{
   public:
     ModelDataImpl();
-    void load(std::string const&fileName);
+    void load(std::string const&fileName,MeshOptimization optimization,bool lods,bool streamImages);
+    void loadSource(std::string const&fileName,MeshOptimization optimization,bool lods);
+    void bake(std::string const&fileName,MeshOptimization optimization,bool lods);
     ~ModelDataImpl();
     Model getModel();
+    Model buildModel();
+    std::vector<Node>loadRoots()const;
+    bool loadMappedGLB(std::string const&fileName);
+    bool decodeStoredImages();
+    void computeImageOpacity();
+    void readImageInfo();
+    std::vector<TextureSource>getTextureSources();
     bool ret = false;
+    ModelLoadTimes times;
     tinygltf::Model model;
     tinygltf::TinyGLTF loader;
+    MappedFile mappedFile;  ///< mapped .glb file
+    Buffer     mappedBuffer;///< buffer 0 that points into BIN chunk of mappedFile
+    ModelCache cache;       ///< baked model (used instead of tinygltf model if it is loaded)
+    Model               optimizedModel    ;///< model with optimized meshes or levels of detail (used if optimization is not NONE or lods are generated)
+    std::vector<uint8_t>optimizedStorage  ;///< buffer with optimized meshes
+    std::vector<uint8_t>lodStorage        ;///< buffer with indices of levels of detail
+    bool                optimized = false ;///< is optimizedModel used
+    std::vector<uint8_t>opaqueImages      ;///< does image have alpha 1 everywhere (computed once after decoding)
+    bool                streamImages = false;///< images are not decoded, their encoded bytes are kept for TextureResidency
+    std::vector<EncodedImage>encodedImages;///< encoded bytes of every image (only if images are streamed)
+    SceneGraph          sceneGraph        ;///< flattened nodes of the model (built once per load)
 };
 
 ModelDataImpl::ModelDataImpl(){
+  loader.SetImageLoader(storeEncodedImage,nullptr);
 }
 
-void ModelDataImpl::load(std::string const&fileName){
+/**
+ * @brief This function loads model from its baked cache (see ModelData::bake) or from glTF if the cache is missing or stale.
+ *
+ * @param fileName .gltf or .glb file
+ * @param optimization optimization of meshes done after loading
+ * @param lods generate levels of detail of meshes
+ * @param streamImages images are not decoded (see ModelData::getTextureSources)
+ */
+void ModelDataImpl::load(std::string const&fileName,MeshOptimization optimization,bool lods,bool streamImages){
+  Timer<float>timer;
+  times = ModelLoadTimes();
+  this->streamImages = streamImages;
+  if(cache.load(modelCacheFile(fileName),fileName,optimization,lods)){
+    ret             = true;
+    times.fromCache = true;
+    sceneGraph.build(cache.getModel().roots);
+    times.total     = timer.elapsedFromStart();
+    return;
+  }
+  loadSource(fileName,optimization,lods);
+}
+
+void ModelDataImpl::loadSource(std::string const&fileName,MeshOptimization optimization,bool lods){
+  Timer<float>timer;
+  times = ModelLoadTimes();
+  cache.close();
+  optimized = false;
+  encodedImages.clear();
   std::string err;
   std::string warn;
-  if(fileName.find(".glb")==fileName.length()-4)
-    ret = loader.LoadBinaryFromFile(&model, &err, &warn, fileName.c_str());
+  if(fileName.find(".glb")==fileName.length()-4){
+    ret = loadMappedGLB(fileName);
+    if(!ret){
+      model        = tinygltf::Model();
+      mappedBuffer = Buffer();
+      mappedFile.close();
+      times        = ModelLoadTimes();
+      timer.reset();
+      ret = loader.LoadBinaryFromFile(&model, &err, &warn, fileName.c_str());
+      times.json = timer.elapsedFromStart();
+      ret = ret && decodeStoredImages();
+    }
+  }
 
-  if(fileName.find(".gltf")==fileName.length()-5)
+  if(fileName.find(".gltf")==fileName.length()-5){
     ret = loader.LoadASCIIFromFile(&model, &err, &warn, fileName.c_str());
+    times.json = timer.elapsedFromStart();
+    ret = ret && decodeStoredImages();
+  }
 
+  if(ret && streamImages)readImageInfo();
+  else if(ret)computeImageOpacity();
+
+  if(ret && (optimization != MeshOptimization::NONE || lods)){
+    Timer<float>meshTimer;
+    optimizedModel  = buildModel();
+    times.meshStats = optimizeMeshes(optimizedModel,optimizedStorage,optimization);
+    times.meshes    = meshTimer.elapsedFromStart();
+    if(lods){
+      meshTimer.reset();
+      generateMeshLods(optimizedModel,lodStorage);
+      times.lods = meshTimer.elapsedFromStart();
+      for(auto const&m:optimizedModel.meshes)times.nofLods += m.nofLods;
+    }
+    optimized       = true;
+  }
+
+  if(ret)sceneGraph.build(loadRoots());
+  else   sceneGraph = SceneGraph();
+
+  times.total = timer.elapsedFromStart();
   if(!ret)
     std::cerr << "model: " << fileName << "was not loaded" << std::endl;
 }
 
+/**
+ * @brief This function decodes images whose encoded bytes were stored by tinygltf (see storeEncodedImage).
+ * Images that were not found keep only their uri like in tinygltf.
+ *
+ * @return false if an image cannot be decoded
+ */
+bool ModelDataImpl::decodeStoredImages(){
+  Timer<float>timer;
+  std::vector<EncodedImage>encoded;
+  for(auto&img:model.images){
+    if(img.image.empty())continue;
+    encoded.push_back({&img,img.image.data(),img.image.size()});
+  }
+  if(streamImages){
+    encodedImages = std::move(encoded);
+    return true;
+  }
+  auto const success = decodeImages(encoded,times.decodeThreads);
+  times.nofImages = (uint32_t)encoded.size();
+  times.images    = timer.elapsedFromStart();
+  if(!success)std::cerr << "model: some images cannot be decoded" << std::endl;
+  return success;
+}
+
+/**
+ * @brief This function finds decoded images whose alpha is 1 everywhere (see Texture::opaque).
+ * It is done once per load, so renderers do not have to scan texels.
+ */
+void ModelDataImpl::computeImageOpacity(){
+  opaqueImages.assign(model.images.size(),0);
+  for(size_t i=0;i<model.images.size();++i){
+    auto const&img = model.images[i];
+    if(img.image.empty())continue;
+    if(img.component < 4){
+      opaqueImages[i] = 1;
+      continue;
+    }
+    // alpha of 16 bit images is opaque if both of its bytes are 0xff
+    size_t const componentSize = img.bits == 16 ? 2 : 1;
+    size_t const pixelSize     = componentSize*img.component;
+    bool opaque = true;
+    for(size_t p=3*componentSize;p<img.image.size() && opaque;p+=pixelSize)
+      for(size_t b=0;b<componentSize;++b)opaque &= img.image[p+b] == 0xff;
+    opaqueImages[i] = opaque;
+  }
+}
+
+/**
+ * @brief This function reads sizes of images that are streamed (they are not decoded).
+ * Images are decoded to 8 bit RGBA by TextureResidency, their opacity is not known.
+ */
+void ModelDataImpl::readImageInfo(){
+  opaqueImages.assign(model.images.size(),0);
+  for(auto const&e:encodedImages){
+    int w = 0,h = 0,comp = 0;
+    if(!stbi_info_from_memory(e.data,(int)e.size,&w,&h,&comp))w = h = 0;
+    e.image->width     = w;
+    e.image->height    = h;
+    e.image->component = 4;
+    e.image->bits      = 8;
+  }
+}
+
+/**
+ * @brief This function returns sources of textures of the model (in order of Model::textures).
+ * Streamed images are decoded from their encoded bytes, other textures are copied from the model or the mapped cache.
+ *
+ * @return sources, they are valid as long as this object exists and the model is not reloaded
+ */
+std::vector<TextureSource>ModelDataImpl::getTextureSources(){
+  std::vector<TextureSource>res;
+  if(!ret)return res;
+  if(streamImages && !cache.isLoaded()){
+    res.resize(model.images.size());
+    for(auto const&e:encodedImages){
+      auto&s    = res.at(e.image-model.images.data());
+      s.width    = (uint32_t)e.image->width ;
+      s.height   = (uint32_t)e.image->height;
+      s.channels = 4;
+      if(!s.width || !s.height)continue;
+      s.load = [e,w=s.width,h=s.height](std::vector<uint8_t>&pixels){
+        int x = 0,y = 0,comp = 0;
+        auto const decoded = stbi_load_from_memory(e.data,(int)e.size,&x,&y,&comp,4);
+        if(!decoded)return false;
+        bool const valid = (uint32_t)x == w && (uint32_t)y == h;
+        if(valid)pixels.assign(decoded,decoded+(size_t)w*h*4);
+        stbi_image_free(decoded);
+        return valid;
+      };
+    }
+    return res;
+  }
+  for(auto const&t:getModel().textures){
+    res.emplace_back();
+    auto&s    = res.back();
+    s.width    = t.width   ;
+    s.height   = t.height  ;
+    s.channels = t.channels;
+    if(!t.data)continue;
+    s.load = [t](std::vector<uint8_t>&pixels){
+      pixels.assign(t.data,t.data+(size_t)t.width*t.height*t.channels);
+      return true;
+    };
+  }
+  return res;
+}
+
 ModelDataImpl::~ModelDataImpl(){
 }
 
-Node loadNode(tinygltf::Node const&root,tinygltf::Model const&model){
-  Node res;
+/**
+ * @brief This function loads .glb file without copying its binary chunk.
+ * The file is mapped into memory, JSON chunk is parsed by tinygltf (without buffers and images)
+ * and buffer 0 points directly into the mapped BIN chunk. Images are decoded from the mapped memory.
+ * Only the common layout is supported: one buffer stored in BIN chunk, images stored in buffer views.
+ *
+ * @param fileName .glb file
+ *
+ * @return false if the file is not supported (the caller falls back to tinygltf)
+ */
+bool ModelDataImpl::loadMappedGLB(std::string const&fileName){
+  uint32_t const glbMagic  = 0x46546C67;// "glTF"
+  uint32_t const jsonChunk = 0x4E4F534A;// "JSON"
+  uint32_t const binChunk  = 0x004E4942;// "BIN\0"
+
+  if(!mappedFile.open(fileName))return false;
+  auto const data = mappedFile.data();
+  auto const size = mappedFile.size();
+
+  // header (magic, version, length) + json chunk header (length, type)
+  uint32_t header[5];
+  if(size < sizeof(header))return false;
+  std::memcpy(header,data,sizeof(header));
+  if(header[0] != glbMagic || header[1] != 2 || header[2] > size || header[4] != jsonChunk)return false;
+  uint64_t const fileLength = header[2];
+  uint64_t const jsonStart  = sizeof(header);
+  uint64_t const jsonEnd    = jsonStart + header[3];
+  if(jsonEnd > fileLength)return false;
+
+  uint8_t const*bin     = nullptr;
+  uint64_t      binSize = 0;
+  if(jsonEnd + 8 <= fileLength){
+    uint32_t chunk[2];
+    std::memcpy(chunk,data+jsonEnd,sizeof(chunk));
+    if(chunk[1] != binChunk || jsonEnd + 8 + chunk[0] > fileLength)return false;
+    bin     = data + jsonEnd + 8;
+    binSize = chunk[0];
+  }
+
+  auto json = nlohmann::json::parse(data+jsonStart,data+jsonEnd,nullptr,false);
+  if(json.is_discarded() || !json.is_object())return false;
+
+  auto const buffers = json.value("buffers",nlohmann::json::array());
+  auto const images  = json.value("images" ,nlohmann::json::array());
+  if(!buffers.is_array() || buffers.size() > 1 || !images.is_array())return false;
+  uint64_t bufferSize = 0;
+  if(buffers.size() == 1){
+    auto const&b = buffers[0];
+    if(!b.is_object() || b.count("uri") || !b.count("byteLength") || !b["byteLength"].is_number_unsigned())return false;
+    bufferSize = b["byteLength"].get<uint64_t>();
+    if(bufferSize > binSize)return false;
+  }
+  // images are located using JSON bufferViews, so they can be decoded while tinygltf parses the rest
+  auto const views = json.value("bufferViews",nlohmann::json::array());
+  std::vector<tinygltf::Image>decoded(images.size());
+  std::vector<EncodedImage>encoded;
+  for(size_t i=0;i<images.size();++i){
+    auto const&img = images[i];
+    if(!img.is_object() || !img.count("bufferView") || !img["bufferView"].is_number_unsigned())return false;
+    auto const viewId = img["bufferView"].get<size_t>();
+    if(!views.is_array() || viewId >= views.size() || !views[viewId].is_object())return false;
+    auto const&view   = views[viewId];
+    auto const offset = view.value("byteOffset",uint64_t(0));
+    auto const length = view.value("byteLength",uint64_t(0));
+    if(view.value("buffer",uint64_t(0)) != 0 || offset + length > bufferSize)return false;
+    decoded[i].name       = img.value("name"    ,std::string());
+    decoded[i].mimeType   = img.value("mimeType",std::string());
+    decoded[i].bufferView = (int)viewId;
+    encoded.push_back({&decoded[i],bin+offset,length});
+  }
+  auto decoding = std::async(std::launch::async,[&](){
+    Timer<float>timer;
+    auto const success = streamImages || decodeImages(encoded,times.decodeThreads);
+    times.images = timer.elapsedFromStart();
+    return success;
+  });
+
+  json.erase("buffers");
+  json.erase("images" );
+  auto const text = json.dump();
+  std::string err;
+  std::string warn;
+  auto const pos = fileName.find_last_of("/\\");
+  auto const baseDir = pos == std::string::npos ? std::string(".") : fileName.substr(0,pos);
+  Timer<float>timer;
+  auto const parsed = loader.LoadASCIIFromString(&model,&err,&warn,text.c_str(),(unsigned)text.size(),baseDir);
+  times.json = timer.elapsedFromStart();
+  auto const decodedAll = decoding.get();
+  if(!parsed || !decodedAll)return false;
+  model.images    = std::move(decoded);
+  times.nofImages = streamImages?0:(uint32_t)encoded.size();
+  // moving keeps the images at the same address
+  if(streamImages)encodedImages = std::move(encoded);
+
+  mappedBuffer.data = bin;
+  mappedBuffer.size = bufferSize;
+  return true;
+}
+
+/**
+ * @brief This function loads node tree, children are loaded directly into their place in the parent.
+ *
+ * @param res output node
+ * @param root glTF node
+ * @param model glTF model
+ */
+void loadNode(Node&res,tinygltf::Node const&root,tinygltf::Model const&model){
   res.mesh = root.mesh;
   //std::cerr << "M: " << root.matrix.size() << " T: " << root.translation.size() << " R: " << root.rotation.size() << " S: " << root.scale.size() << " W: " << root.weights.size() << std::endl;
   if(root.matrix.size() == 16){
@@ -95,14 +487,59 @@ Node loadNode(tinygltf::Node const&root,tinygltf::Model const&model){
       res.modelMatrix = res.modelMatrix*glm::scale(glm::mat4(1.f),glm::vec3(p[0],p[1],p[2]));
     }
   }
-  for(auto c:root.children)
-    res.children.emplace_back(loadNode(model.nodes.at(c),model));
+  res.children.resize(root.children.size());
+  for(size_t c=0;c<root.children.size();++c)
+    loadNode(res.children[c],model.nodes.at(root.children[c]),model);
+}
+
+/**
+ * @brief This function loads node trees of the first scene.
+ *
+ * @return roots of node trees
+ */
+std::vector<Node>ModelDataImpl::loadRoots()const{
+  auto const&scene = model.scenes.at(0);
+  std::vector<Node>res(scene.nodes.size());
+  for(size_t i=0;i<scene.nodes.size();++i)
+    loadNode(res[i],model.nodes.at(scene.nodes[i]),model);
   return res;
 }
 
+/**
+ * @brief This function loads model from glTF and stores it into cache file.
+ * Files referenced by the model are stored in the cache too, so the cache becomes stale if any of them changes.
+ *
+ * @param fileName .gltf or .glb file
+ * @param optimization optimization of meshes that is stored in the cache
+ * @param lods generate levels of detail of meshes and store them in the cache
+ */
+void ModelDataImpl::bake(std::string const&fileName,MeshOptimization optimization,bool lods){
+  streamImages = false;
+  loadSource(fileName,optimization,lods);
+  if(!ret)throw std::runtime_error("model cache: cannot load model: "+fileName);
+  std::vector<std::string>dependencies;
+  auto const addDependency = [&](std::string const&uri){
+    if(!uri.empty() && uri.compare(0,5,"data:") != 0)dependencies.push_back(uri);
+  };
+  for(auto const&b:model.buffers)addDependency(b.uri);
+  for(auto const&i:model.images )addDependency(i.uri);
+  writeModelCache(modelCacheFile(fileName),fileName,dependencies,getModel(),optimization,lods);
+}
+
 Model ModelDataImpl::getModel(){
+  if(!ret)return Model();
+  if(cache.isLoaded())return cache.getModel();
+  if(optimized)return optimizedModel;
+  return buildModel();
+}
+
+/**
+ * @brief This function converts tinygltf model into Model.
+ *
+ * @return model
+ */
+Model ModelDataImpl::buildModel(){
   Model res;
-  if(!ret)return res;
 
   //std::cerr << "nofMeshes   : " << model.meshes   .size() << std::endl;
   //std::cerr << "nofNodes    : " << model.nodes    .size() << std::endl;
@@ -110,18 +547,10 @@ Model ModelDataImpl::getModel(){
   //std::cerr << "nofImages   : " << model.images   .size() << std::endl;
   //std::cerr << "nofTextures : " << model.textures .size() << std::endl;
 
-  //std::cerr << "before loaded nodes" << std::endl;
-  auto const&scene = model.scenes.at(0);
-  for(auto const&node_id:scene.nodes){
-    //std::cerr << __LINE__ << std::endl;
-    auto const&root = model.nodes.at(node_id);
-    //std::cerr << __LINE__ << std::endl;
-    res.roots.push_back(loadNode(root,model));
-    //std::cerr << __LINE__ << std::endl;
-  }
-  //std::cerr << "loaded nodes" << std::endl;
+  res.roots = loadRoots();
 
-  for(auto const&img:model.images){
+  for(size_t i=0;i<model.images.size();++i){
+    auto const&img = model.images[i];
     res.textures.push_back({});
     auto&tex = res.textures.back();
     //std::cerr << "w: " << img.width << " h: " << img.height << " c: " << img.component << " \"" << img.name << "\"" << std::endl;
@@ -129,7 +558,8 @@ Model ModelDataImpl::getModel(){
     tex.width    = img.width;
     tex.height   = img.height;
     tex.channels = img.component;
-    tex.data     = img.image.data();
+    tex.data     = streamImages?nullptr:img.image.data();
+    tex.opaque   = opaqueImages.at(i) != 0;
   }
 
   for(auto const&buf:model.buffers){
@@ -139,6 +569,10 @@ Model ModelDataImpl::getModel(){
     res.buffers.push_back(buffer);
   }
 
+  // mapped .glb has only one buffer
+  if(mappedBuffer.data)
+    res.buffers.push_back(mappedBuffer);
+
   for(auto const&mesh:model.meshes){
     
     //std::cerr <<__FILE__ << "/" << __LINE__ << std::endl;
@@ -242,12 +676,23 @@ Model ModelDataImpl::getModel(){
           att->offset     = offset + accessor.byteOffset;
           att->stride     = stride;
 
-          if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT){
-            if(accessor.type == TINYGLTF_TYPE_SCALAR)att->type = AttributeType::FLOAT;
-            if(accessor.type == TINYGLTF_TYPE_VEC2  )att->type = AttributeType::VEC2 ;
-            if(accessor.type == TINYGLTF_TYPE_VEC3  )att->type = AttributeType::VEC3 ;
-            if(accessor.type == TINYGLTF_TYPE_VEC4  )att->type = AttributeType::VEC4 ;
-            if(att->stride == 0)att->stride = sizeof(float)*(uint32_t)att->type;
+          // float or normalized integer components (KHR_mesh_quantization), first type of the family has 1 component
+          AttributeType first = AttributeType::EMPTY;
+          if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)first = AttributeType::FLOAT;
+          if(accessor.normalized){
+            if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_BYTE          )first = AttributeType::SNORM8 ;
+            if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE )first = AttributeType::UNORM8 ;
+            if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_SHORT         )first = AttributeType::SNORM16;
+            if(accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)first = AttributeType::UNORM16;
+          }
+          uint32_t components = 0;
+          if(accessor.type == TINYGLTF_TYPE_SCALAR)components = 1;
+          if(accessor.type == TINYGLTF_TYPE_VEC2  )components = 2;
+          if(accessor.type == TINYGLTF_TYPE_VEC3  )components = 3;
+          if(accessor.type == TINYGLTF_TYPE_VEC4  )components = 4;
+          if(first != AttributeType::EMPTY && components){
+            att->type = (AttributeType)((uint32_t)first-1+components);
+            if(att->stride == 0)att->stride = attributeTypeSize(att->type);
           }
           //std::cerr << "  bufId : " << bufId       << std::endl;
           //std::cerr << "  stride: " << att->stride << std::endl;
@@ -272,8 +717,25 @@ Model ModelDataImpl::getModel(){
   return res;
 }
 
-void ModelData::load(std::string const&fileName){
-  impl->load(fileName);
+/**
+ * @brief This function loads model.
+ *
+ * @param fileName .gltf or .glb file
+ * @param optimization optimization of meshes done after loading (see optimizeMeshes)
+ * @param lods generate levels of detail of meshes after loading (see generateMeshLods)
+ * @param streamImages images are not decoded, textures of the model have no data and they are read by TextureResidency (see getTextureSources)
+ */
+void ModelData::load(std::string const&fileName,MeshOptimization optimization,bool lods,bool streamImages){
+  impl->load(fileName,optimization,lods,streamImages);
+}
+
+/**
+ * @brief This function returns sources of textures of the model for TextureResidency.
+ *
+ * @return source of every texture of getModel, they are valid as long as this object exists
+ */
+std::vector<TextureSource>ModelData::getTextureSources(){
+  return impl->getTextureSources();
 }
 
 ModelData::ModelData(){
@@ -287,3 +749,39 @@ ModelData::~ModelData(){
 Model ModelData::getModel(){
   return impl->getModel();
 }
+
+/**
+ * @brief This function returns flattened nodes of getModel, the graph is built once when the model is loaded.
+ *
+ * @return scene graph of getModel().roots
+ */
+SceneGraph const&ModelData::getSceneGraph()const{
+  return impl->sceneGraph;
+}
+
+/**
+ * @brief This function bakes model into binary cache file (modelCacheFile).
+ * Next load of the model uses the cache, it skips parsing of glTF and decoding of images.
+ *
+ * @param fileName .gltf or .glb file
+ * @param optimization optimization of meshes that is stored in the cache
+ * @param lods generate levels of detail of meshes and store them in the cache
+ */
+void ModelData::bake(std::string const&fileName,MeshOptimization optimization,bool lods){
+  impl->bake(fileName,optimization,lods);
+}
+
+ModelLoadTimes ModelData::getLoadTimes()const{
+  return impl->times;
+}
+
+std::ostream&operator<<(std::ostream&os,ModelLoadTimes const&times){
+  if(times.fromCache)
+    return os << "model: loaded from cache in " << times.total << " s";
+  os << "model: loaded in " << times.total << " s (json: " << times.json << " s, " << times.nofImages << " images: " << times.images << " s on " << times.decodeThreads << " threads)";
+  if(times.meshStats.nofTriangles)
+    os << ", " << times.meshStats.nofTriangles << " triangles optimized in " << times.meshes << " s (ACMR " << times.meshStats.acmrBefore << " -> " << times.meshStats.acmrAfter << ")";
+  if(times.nofLods)
+    os << ", " << times.nofLods << " levels of detail generated in " << times.lods << " s";
+  return os;
+}
@@ -5,14 +5,40 @@
 #include<iostream>
 
 #include<student/fwd.hpp>
+#include<framework/meshOptimizer.hpp>
+#include<framework/textureResidency.hpp>
+#include<student/sceneGraph.hpp>
+
+/**
+ * @brief Durations of model loading stages in seconds.
+ * JSON parsing and image decoding of .glb files overlap, so the stages do not sum up to total.
+ */
+struct ModelLoadTimes{
+  float    json          = 0.f  ;///< parsing of glTF JSON (including external buffers)
+  float    images        = 0.f  ;///< decoding of images
+  float    total         = 0.f  ;///< whole load
+  uint32_t nofImages     = 0    ;///< number of decoded images
+  uint32_t decodeThreads = 0    ;///< number of threads that decoded images
+  float    meshes        = 0.f  ;///< optimization of meshes
+  float    lods          = 0.f  ;///< generation of levels of detail
+  uint32_t nofLods       = 0    ;///< number of generated levels of detail (all meshes)
+  bool     fromCache     = false;///< was the model loaded from baked cache (nothing was parsed or decoded)
+  MeshOptimizationStats meshStats;///< vertex cache efficiency of optimized meshes
+};
+
+std::ostream&operator<<(std::ostream&os,ModelLoadTimes const&times);
 
 class ModelDataImpl;
 class ModelData{
   public:
     ModelData();
-    void load(std::string const&fileName);
+    void load(std::string const&fileName,MeshOptimization optimization = MeshOptimization::NONE,bool lods = false,bool streamImages = false);
     ~ModelData();
     Model getModel();
+    SceneGraph const&getSceneGraph()const;
+    std::vector<TextureSource>getTextureSources();
+    void bake(std::string const&fileName,MeshOptimization optimization = MeshOptimization::NONE,bool lods = false);
+    ModelLoadTimes getLoadTimes()const;
   private:
     friend class ModelDataImpl;
     ModelDataImpl*impl = nullptr;
@@ -0,0 +1,262 @@
+#include<framework/modelCache.hpp>
+#include<framework/binaryStream.hpp>
+
+#include<filesystem>
+#include<iostream>
+
+namespace{
+char     const cacheMagic[8] = {'I','Z','G','M','D','L','0','1'};
+uint32_t const cacheVersion  = 6;
+size_t   const dataAlignment = 16;
+
+/**
+ * @brief This function computes FNV-1a hash of bytes (8 bytes per step).
+ */
+uint64_t hashBytes(uint8_t const*data,size_t size){
+  uint64_t const prime = 0x100000001b3ull;
+  uint64_t h = 0xcbf29ce484222325ull;
+  size_t i=0;
+  for(;i+8<=size;i+=8){
+    uint64_t w;
+    std::memcpy(&w,data+i,sizeof(w));
+    h = (h ^ w)*prime;
+  }
+  for(;i<size;++i)h = (h ^ data[i])*prime;
+  return h;
+}
+
+/**
+ * @brief Size, modification time and hash of a file the cache was baked from.
+ */
+struct FileHash{
+  uint64_t size  = 0;
+  int64_t  mtime = 0;///< last write time in ticks of std::filesystem clock
+  uint64_t hash  = 0;
+};
+
+/**
+ * @brief This function reads size and modification time of file (it does not read the file).
+ */
+bool statFile(std::string const&fileName,FileHash&res){
+  std::error_code ec;
+  auto const size  = std::filesystem::file_size(fileName,ec);
+  if(ec)return false;
+  auto const mtime = std::filesystem::last_write_time(fileName,ec);
+  if(ec)return false;
+  res.size  = size;
+  res.mtime = (int64_t)mtime.time_since_epoch().count();
+  return true;
+}
+
+bool hashFile(std::string const&fileName,FileHash&res){
+  MappedFile file;
+  if(!file.open(fileName))return false;
+  res.size = file.size();
+  res.hash = hashBytes(file.data(),file.size());
+  return true;
+}
+
+/**
+ * @brief This function checks that file was not changed since the cache was baked.
+ * Files of the same size and modification time are not read, other files of the same size are hashed
+ * (e.g. a copied or touched model keeps its cache).
+ *
+ * @param fileName file
+ * @param stored size, modification time and hash stored in the cache
+ *
+ * @return true if the file has the same content
+ */
+bool isUnchanged(std::string const&fileName,FileHash const&stored){
+  FileHash current;
+  if(!statFile(fileName,current) || current.size != stored.size)return false;
+  if(current.mtime == stored.mtime)return true;
+  return hashFile(fileName,current) && current.hash == stored.hash;
+}
+
+std::string directoryOf(std::string const&fileName){
+  auto const pos = fileName.find_last_of("/\\");
+  return pos == std::string::npos ? std::string(".") : fileName.substr(0,pos);
+}
+
+void writePadding(BinaryWriter&w){
+  while(w.data.size()%dataAlignment)w.write((uint8_t)0);
+}
+
+void skipPadding(BinaryReader&r){
+  r.skip((dataAlignment - r.offset%dataAlignment)%dataAlignment);
+}
+
+void writeNode(BinaryWriter&w,Node const&node){
+  w.writeBytes(&node.modelMatrix,sizeof(node.modelMatrix));
+  w.write(node.mesh);
+  w.write((uint32_t)node.children.size());
+  for(auto const&c:node.children)writeNode(w,c);
+}
+
+void readNode(BinaryReader&r,Node&res){
+  r.readBytes(&res.modelMatrix,sizeof(res.modelMatrix));
+  res.mesh = r.read<int32_t>();
+  res.children.resize(r.read<uint32_t>());
+  for(auto&c:res.children)readNode(r,c);
+}
+
+}
+
+/**
+ * @brief This function returns name of cache file of model.
+ *
+ * @param modelFile .gltf or .glb file
+ *
+ * @return cache file
+ */
+std::string modelCacheFile(std::string const&modelFile){
+  return modelFile+".izgmodel";
+}
+
+/**
+ * @brief This function bakes model into cache file.
+ *
+ * @param cacheFile output cache file
+ * @param sourceFile model file the model was loaded from
+ * @param dependencies files referenced by the model (relative to directory of sourceFile)
+ * @param model loaded model
+ * @param optimization optimization that was applied on meshes of the model
+ * @param lods were levels of detail of meshes generated
+ */
+void writeModelCache(std::string const&cacheFile,std::string const&sourceFile,std::vector<std::string>const&dependencies,Model const&model,MeshOptimization optimization,bool lods){
+  BinaryWriter w;
+  w.writeBytes(cacheMagic,sizeof(cacheMagic));
+  w.write(cacheVersion);
+  w.write((uint32_t)sizeof(Mesh));
+  w.write((uint32_t)optimization);
+  w.write((uint32_t)lods);
+
+  // source file is stored with empty name, missing dependencies are not stored
+  auto const dir = directoryOf(sourceFile);
+  std::vector<std::pair<std::string,FileHash>>files;
+  FileHash sourceHash;
+  if(!statFile(sourceFile,sourceHash) || !hashFile(sourceFile,sourceHash))throw std::runtime_error("model cache: cannot read model: "+sourceFile);
+  files.emplace_back("",sourceHash);
+  for(auto const&d:dependencies){
+    FileHash h;
+    if(statFile(dir+"/"+d,h) && hashFile(dir+"/"+d,h))files.emplace_back(d,h);
+  }
+  w.write((uint32_t)files.size());
+  for(auto const&f:files){
+    w.writeString(f.first);
+    w.write(f.second.size );
+    w.write(f.second.mtime);
+    w.write(f.second.hash );
+  }
+
+  w.write((uint32_t)model.meshes.size());
+  w.writeBytes(model.meshes.data(),sizeof(Mesh)*model.meshes.size());
+
+  w.write((uint32_t)model.roots.size());
+  for(auto const&r:model.roots)writeNode(w,r);
+
+  w.write((uint32_t)model.buffers.size());
+  for(auto const&b:model.buffers){
+    w.write(b.size);
+    writePadding(w);
+    w.writeBytes(b.data,b.size);
+  }
+
+  w.write((uint32_t)model.textures.size());
+  for(auto const&t:model.textures){
+    uint64_t const size = t.data?(uint64_t)t.width*t.height*t.channels:0;
+    w.write(t.width   );
+    w.write(t.height  );
+    w.write(t.channels);
+    w.write((uint32_t)t.opaque);
+    w.write(size      );
+    writePadding(w);
+    w.writeBytes(t.data,size);
+  }
+
+  w.save(cacheFile);
+}
+
+/**
+ * @brief This function maps cache file and checks that it was baked from current version of the model.
+ *
+ * @param cacheFile cache file
+ * @param sourceFile model file
+ * @param optimization required optimization of meshes
+ * @param lods are levels of detail of meshes required
+ *
+ * @return false if the cache does not exist, it is stale, it was baked with different optimization or it is corrupted
+ */
+bool ModelCache::load(std::string const&cacheFile,std::string const&sourceFile,MeshOptimization optimization,bool lods){
+  close();
+  if(!file.open(cacheFile))return false;
+  try{
+    BinaryReader r(file.data(),file.size());
+    char magic[sizeof(cacheMagic)];
+    r.readBytes(magic,sizeof(magic));
+    if(std::memcmp(magic,cacheMagic,sizeof(magic)) != 0 || r.read<uint32_t>() != cacheVersion || r.read<uint32_t>() != sizeof(Mesh)){
+      std::cerr << "model cache: " << cacheFile << " was baked by incompatible build" << std::endl;
+      close();
+      return false;
+    }
+    auto const storedOptimization = r.read<uint32_t>();
+    auto const storedLods         = r.read<uint32_t>();
+    if(storedOptimization != (uint32_t)optimization || storedLods != (uint32_t)lods){
+      std::cerr << "model cache: " << cacheFile << " was baked with different mesh optimization or levels of detail" << std::endl;
+      close();
+      return false;
+    }
+
+    auto const dir = directoryOf(sourceFile);
+    auto const nofFiles = r.read<uint32_t>();
+    for(uint32_t i=0;i<nofFiles;++i){
+      auto const name = r.readString();
+      FileHash stored;
+      stored.size  = r.read<uint64_t>();
+      stored.mtime = r.read<int64_t >();
+      stored.hash  = r.read<uint64_t>();
+      if(!isUnchanged(name.empty()?sourceFile:dir+"/"+name,stored)){
+        std::cerr << "model cache: " << cacheFile << " is stale" << std::endl;
+        close();
+        return false;
+      }
+    }
+
+    model.meshes.resize(r.read<uint32_t>());
+    r.readBytes(model.meshes.data(),sizeof(Mesh)*model.meshes.size());
+
+    model.roots.resize(r.read<uint32_t>());
+    for(auto&root:model.roots)readNode(r,root);
+
+    model.buffers.resize(r.read<uint32_t>());
+    for(auto&b:model.buffers){
+      b.size = r.read<uint64_t>();
+      skipPadding(r);
+      b.data = b.size?r.skip(b.size):nullptr;
+    }
+
+    model.textures.resize(r.read<uint32_t>());
+    for(auto&t:model.textures){
+      t.width    = r.read<uint32_t>();
+      t.height   = r.read<uint32_t>();
+      t.channels = r.read<uint32_t>();
+      t.opaque   = r.read<uint32_t>() != 0;
+      auto const size = r.read<uint64_t>();
+      skipPadding(r);
+      t.data = size?r.skip(size):nullptr;
+    }
+    if(!r.atEnd())throw std::runtime_error("unexpected data at the end");
+  }catch(std::exception const&e){
+    std::cerr << "model cache: " << cacheFile << " is corrupted: " << e.what() << std::endl;
+    close();
+    return false;
+  }
+  loaded = true;
+  return true;
+}
+
+void ModelCache::close(){
+  model  = Model();
+  loaded = false;
+  file.close();
+}
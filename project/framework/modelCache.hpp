@@ -0,0 +1,38 @@
+/*!
+ * @file
+ * @brief This file contains binary cache of baked models.
+ *
+ * A cache file holds everything that ModelData::getModel produces: meshes, nodes (stored in pre-order),
+ * buffers and decoded textures. Buffers and textures are aligned, so they are used directly from
+ * the mapped cache file. The cache stores size, modification time and hash of the source model and of all files
+ * it references, files are hashed only if their modification time changed. A stale cache is ignored and the model
+ * is loaded from glTF. Meshes are stored after optimization
+ * (see MeshOptimization) together with their levels of detail, a cache baked with different options is ignored too.
+ */
+
+#pragma once
+
+#include<string>
+#include<vector>
+
+#include<student/fwd.hpp>
+#include<framework/mappedFile.hpp>
+#include<framework/meshOptimizer.hpp>
+
+/**
+ * @brief This class represents model loaded from mapped cache file.
+ */
+class ModelCache{
+  public:
+    bool load(std::string const&cacheFile,std::string const&sourceFile,MeshOptimization optimization,bool lods);
+    void close();
+    bool isLoaded()const{return loaded;}///< was the cache loaded
+    Model const&getModel()const{return model;}///< cached model (buffers and textures point into the mapped file)
+  private:
+    MappedFile file         ;
+    Model      model        ;
+    bool       loaded = false;
+};
+
+std::string modelCacheFile(std::string const&modelFile);
+void writeModelCache(std::string const&cacheFile,std::string const&sourceFile,std::vector<std::string>const&dependencies,Model const&model,MeshOptimization optimization,bool lods);
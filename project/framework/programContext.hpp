@@ -4,6 +4,7 @@
 #include<functional>
 #include<memory>
 #include<framework/arguments.hpp>
+#include<framework/shaderRegistry.hpp>
 
 
 template<typename CLASS>
@@ -32,6 +33,7 @@ class ProgramContext{
 
     Arguments args;
     MethodDatabase methods;
+    ShaderRegistry shaders;
   protected:
     ProgramContext(ProgramContext &other) = delete;
     void operator=(const ProgramContext &) = delete;
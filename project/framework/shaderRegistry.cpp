@@ -0,0 +1,86 @@
+#include<framework/shaderRegistry.hpp>
+#include<framework/programContext.hpp>
+
+void ShaderRegistry::add(std::string const&name,VertexShader vs){
+  vertexShaders[name]   = vs  ;
+  vertexShaderNames[vs] = name;
+}
+
+void ShaderRegistry::add(std::string const&name,FragmentShader fs){
+  fragmentShaders[name]   = fs  ;
+  fragmentShaderNames[fs] = name;
+}
+
+void ShaderRegistry::add(std::string const&name,DrawPrologue p){
+  drawPrologues[name]    = p   ;
+  drawPrologueNames[p]   = name;
+}
+
+/**
+ * @brief This function returns name of vertex shader
+ *
+ * @param vs vertex shader
+ *
+ * @return name or empty string if the shader is nullptr or it is not registered
+ */
+std::string ShaderRegistry::getName(VertexShader vs)const{
+  auto it = vertexShaderNames.find(vs);
+  if(it == vertexShaderNames.end())return "";
+  return it->second;
+}
+
+/**
+ * @brief This function returns name of fragment shader
+ *
+ * @param fs fragment shader
+ *
+ * @return name or empty string if the shader is nullptr or it is not registered
+ */
+std::string ShaderRegistry::getName(FragmentShader fs)const{
+  auto it = fragmentShaderNames.find(fs);
+  if(it == fragmentShaderNames.end())return "";
+  return it->second;
+}
+
+/**
+ * @brief This function returns name of draw prologue
+ *
+ * @param p draw prologue
+ *
+ * @return name or empty string if the prologue is nullptr or it is not registered
+ */
+std::string ShaderRegistry::getName(DrawPrologue p)const{
+  auto it = drawPrologueNames.find(p);
+  if(it == drawPrologueNames.end())return "";
+  return it->second;
+}
+
+VertexShader ShaderRegistry::getVertexShader(std::string const&name)const{
+  auto it = vertexShaders.find(name);
+  if(it == vertexShaders.end())return nullptr;
+  return it->second;
+}
+
+FragmentShader ShaderRegistry::getFragmentShader(std::string const&name)const{
+  auto it = fragmentShaders.find(name);
+  if(it == fragmentShaders.end())return nullptr;
+  return it->second;
+}
+
+DrawPrologue ShaderRegistry::getDrawPrologue(std::string const&name)const{
+  auto it = drawPrologues.find(name);
+  if(it == drawPrologues.end())return nullptr;
+  return it->second;
+}
+
+void registerShader(std::string const&name,VertexShader vs){
+  ProgramContext::get().shaders.add(name,vs);
+}
+
+void registerShader(std::string const&name,FragmentShader fs){
+  ProgramContext::get().shaders.add(name,fs);
+}
+
+void registerShader(std::string const&name,DrawPrologue p){
+  ProgramContext::get().shaders.add(name,p);
+}
@@ -0,0 +1,39 @@
+/*!
+ * @file
+ * @brief This file contains registry that maps shader functions to stable names.
+ * Names are used by frame captures, function pointers are not stable between builds.
+ */
+
+#pragma once
+
+#include<map>
+#include<string>
+
+#include<student/fwd.hpp>
+
+/**
+ * @brief This class maps shader function pointers to names and back.
+ */
+class ShaderRegistry{
+  public:
+    void add(std::string const&name,VertexShader   vs);
+    void add(std::string const&name,FragmentShader fs);
+    void add(std::string const&name,DrawPrologue   p );
+    std::string    getName          (VertexShader   vs  )const;
+    std::string    getName          (FragmentShader fs  )const;
+    std::string    getName          (DrawPrologue   p   )const;
+    VertexShader   getVertexShader  (std::string const&name)const;
+    FragmentShader getFragmentShader(std::string const&name)const;
+    DrawPrologue   getDrawPrologue  (std::string const&name)const;
+  private:
+    std::map<std::string,VertexShader  >vertexShaders        ;
+    std::map<std::string,FragmentShader>fragmentShaders      ;
+    std::map<std::string,DrawPrologue  >drawPrologues        ;
+    std::map<VertexShader  ,std::string>vertexShaderNames    ;
+    std::map<FragmentShader,std::string>fragmentShaderNames  ;
+    std::map<DrawPrologue  ,std::string>drawPrologueNames    ;
+};
+
+void registerShader(std::string const&name,VertexShader   vs);
+void registerShader(std::string const&name,FragmentShader fs);
+void registerShader(std::string const&name,DrawPrologue   p );
@@ -2,6 +2,7 @@
 
 #include<libs/stb_image/stb_image.h>
 
+#include <cstring>
 #include <iostream>
 
 TextureData loadTexture(std::string const&fileName){
@@ -16,11 +17,10 @@ TextureData loadTexture(std::string const&fileName){
   //std::cerr << "w: " << w << " h: " << h << " c: " << channels << std::endl;
   res.data.resize(w*h*channels);
 
+  // rows are stored bottom to top
+  size_t const rowSize = (size_t)w*channels;
   for(int32_t y=0;y<h;++y)
-    for(int32_t x=0;x<w;++x)
-      for(int32_t c=0;c<channels;++c){
-        res.data[(y*w+x)*channels+c] = data[((h-y-1)*w+x)*channels+c];
-      }
+    std::memcpy(res.data.data()+y*rowSize,data+(h-y-1)*rowSize,rowSize);
 
   res.channels = channels;
   res.height = h;
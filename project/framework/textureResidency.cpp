@@ -0,0 +1,319 @@
+#include<framework/textureResidency.hpp>
+
+#include<algorithm>
+#include<cmath>
+#include<thread>
+
+namespace{
+
+uint32_t levelWidth(TextureSource const&t,uint32_t level){
+  return std::max(t.width>>level,1u);
+}
+
+uint32_t levelHeight(TextureSource const&t,uint32_t level){
+  return std::max(t.height>>level,1u);
+}
+
+/**
+ * @brief This function halves image (2x2 box filter, the last odd row/column is dropped).
+ *
+ * @param src source pixels
+ * @param width width of source
+ * @param height height of source
+ * @param channels number of channels
+ * @param dst output pixels, max(width/2,1) x max(height/2,1)
+ */
+void halve(uint8_t const*src,uint32_t width,uint32_t height,uint32_t channels,std::vector<uint8_t>&dst){
+  uint32_t const w = std::max(width >>1,1u);
+  uint32_t const h = std::max(height>>1,1u);
+  dst.resize((size_t)w*h*channels);
+  for(uint32_t y=0;y<h;++y){
+    uint32_t const y0 = std::min(2*y,height-1),y1 = std::min(2*y+1,height-1);
+    for(uint32_t x=0;x<w;++x){
+      uint32_t const x0 = std::min(2*x,width-1),x1 = std::min(2*x+1,width-1);
+      for(uint32_t c=0;c<channels;++c){
+        uint32_t const sum =
+          src[((size_t)y0*width+x0)*channels+c] + src[((size_t)y0*width+x1)*channels+c] +
+          src[((size_t)y1*width+x0)*channels+c] + src[((size_t)y1*width+x1)*channels+c];
+        dst[((size_t)y*w+x)*channels+c] = (uint8_t)((sum+2)/4);
+      }
+    }
+  }
+}
+
+/**
+ * @brief This function builds coarser level of texture from finer one.
+ *
+ * @param pixels pixels of level from, they are replaced by pixels of level to
+ * @param source texture
+ * @param from level of pixels
+ * @param to output level (to >= from)
+ */
+void downsample(std::vector<uint8_t>&pixels,TextureSource const&source,uint32_t from,uint32_t to){
+  std::vector<uint8_t>next;
+  for(uint32_t l=from;l<to;++l){
+    halve(pixels.data(),levelWidth(source,l),levelHeight(source,l),source.channels,next);
+    pixels.swap(next);
+  }
+  pixels.shrink_to_fit();
+}
+
+/**
+ * @brief This function builds level of texture.
+ * Coarser level is built from the resident level, finer level is read from the source.
+ *
+ * @param source texture
+ * @param resident pixels of the resident level
+ * @param residentLevel resident level
+ * @param level built level
+ *
+ * @return pixels of the level, nullptr if the source cannot be read
+ */
+std::shared_ptr<std::vector<uint8_t>const>buildLevel(TextureSource const&source,std::vector<uint8_t>const&resident,uint32_t residentLevel,uint32_t level){
+  std::vector<uint8_t>pixels;
+  uint32_t from = 0;
+  if(residentLevel < level){
+    halve(resident.data(),levelWidth(source,residentLevel),levelHeight(source,residentLevel),source.channels,pixels);
+    from = residentLevel+1;
+  }else if(!source.load || !source.load(pixels) || pixels.size() < (size_t)source.width*source.height*source.channels)return nullptr;
+  downsample(pixels,source,from,level);
+  return std::make_shared<std::vector<uint8_t>const>(std::move(pixels));
+}
+
+bool isOpaque(std::vector<uint8_t>const&pixels,uint32_t channels){
+  if(channels < 4)return true;
+  for(size_t i=3;i<pixels.size();i+=channels)
+    if(pixels[i] != 0xff)return false;
+  return true;
+}
+
+}
+
+/**
+ * @brief This function initializes residency of textures, only their mip tails are resident.
+ * Every source is read once (in parallel) to build its mip tail and to find out its opacity.
+ *
+ * @param sources full resolution images, their loaders have to be callable as long as this object is used
+ * @param budget memory budget of resident levels in bytes
+ * @param frameLocal levels depend only on requests since the last update (see update)
+ */
+void TextureResidency::init(std::vector<TextureSource>const&sources,uint64_t budget,bool frameLocal){
+  std::lock_guard<std::mutex>updateLock(updateMutex);
+  std::lock_guard<std::mutex>lock(mutex);
+  this->budget     = budget;
+  this->frameLocal = frameLocal;
+  frame = 0;
+  entries.clear();
+  entries.resize(sources.size());
+
+  std::atomic<size_t>next{0};
+  auto const worker = [&](){
+    for(size_t i = next++;i < entries.size();i = next++){
+      auto&e = entries[i];
+      e.source    = sources[i];
+      e.feedback  = std::make_unique<std::atomic<uint32_t>>(~0u);
+      e.tailLevel = 0;
+      while(levelWidth(e.source,e.tailLevel) > textureTailSize || levelHeight(e.source,e.tailLevel) > textureTailSize)e.tailLevel++;
+      e.level     = e.tailLevel;
+      std::vector<uint8_t>pixels;
+      if(!e.source.load || !e.source.load(pixels))continue;
+      e.opaque = isOpaque(pixels,e.source.channels);
+      downsample(pixels,e.source,0,e.tailLevel);
+      e.data = std::make_shared<std::vector<uint8_t>const>(std::move(pixels));
+    }
+  };
+  auto nofThreads = std::max(1u,std::thread::hardware_concurrency());
+  nofThreads = std::min<uint32_t>(nofThreads,(uint32_t)std::max<size_t>(entries.size(),1));
+  std::vector<std::thread>threads;
+  for(uint32_t t=1;t<nofThreads;++t)threads.emplace_back(worker);
+  worker();
+  for(auto&t:threads)t.join();
+}
+
+/**
+ * @brief This function initializes residency of textures from another manager without reading the sources,
+ * pixels of its resident levels are shared (e.g. every rendering thread has its own manager).
+ *
+ * @param other initialized manager, its sources have to be callable as long as this object is used
+ * @param budget memory budget of resident levels in bytes
+ * @param frameLocal levels depend only on requests since the last update (see update)
+ */
+void TextureResidency::init(TextureResidency const&other,uint64_t budget,bool frameLocal){
+  std::lock_guard<std::mutex>updateLock(updateMutex);
+  std::lock_guard<std::mutex>lock(mutex);
+  std::lock_guard<std::mutex>otherLock(other.mutex);
+  this->budget     = budget;
+  this->frameLocal = frameLocal;
+  frame = 0;
+  entries.clear();
+  entries.resize(other.entries.size());
+  for(size_t i=0;i<entries.size();++i){
+    auto&e       = entries[i];
+    auto const&o = other.entries[i];
+    e.source    = o.source   ;
+    e.data      = o.data     ;
+    e.opaque    = o.opaque   ;
+    e.level     = o.level    ;
+    e.tailLevel = o.tailLevel;
+    e.feedback  = std::make_unique<std::atomic<uint32_t>>(~0u);
+  }
+}
+
+/**
+ * @brief This function computes level of texture whose size roughly matches size of textured surface on the screen.
+ *
+ * @param texture index of texture
+ * @param pixels size of textured surface on the screen in pixels
+ *
+ * @return level of the texture
+ */
+uint32_t TextureResidency::requiredLevel(uint32_t texture,float pixels)const{
+  std::lock_guard<std::mutex>lock(mutex);
+  auto const&e = entries.at(texture);
+  float const size = (float)std::max(e.source.width,e.source.height);
+  if(!(pixels > 0.f) || pixels >= size)return 0;
+  return std::min((uint32_t)std::log2(size/pixels),e.tailLevel);
+}
+
+/**
+ * @brief This function requests level of texture for the next update (the finest of all requests is used).
+ *
+ * @param texture index of texture
+ * @param level requested level
+ */
+void TextureResidency::request(uint32_t texture,uint32_t level){
+  std::lock_guard<std::mutex>lock(mutex);
+  auto&e = entries.at(texture);
+  e.requested = std::min(e.requested,level);
+}
+
+/**
+ * @brief This function changes resident levels, it has to be called between submissions that sample the textures.
+ * Requested levels (including levels from sampling feedback) are made resident, textures without request keep their level.
+ * If the levels do not fit into the budget, textures sampled the longest time ago are coarsened first
+ * down to their mip tails.
+ * Frame local manager ignores the feedback, textures without request fall back to their mip tails
+ * and textures are coarsened in order of their indices.
+ * New levels are built without the lock, the other functions see the previous levels meanwhile.
+ *
+ * @return true if any resident level changed
+ */
+bool TextureResidency::update(){
+  std::lock_guard<std::mutex>updateLock(updateMutex);
+
+  /**
+   * @brief Level that is built outside of the lock.
+   */
+  struct Job{
+    uint32_t     texture;///< index of texture
+    uint32_t     level  ;///< new resident level
+    TextureSource source;///< texture
+    uint32_t     residentLevel;///< current resident level
+    std::shared_ptr<std::vector<uint8_t>const>resident;///< pixels of current resident level
+  };
+  std::vector<Job>jobs;
+
+  {
+    std::lock_guard<std::mutex>lock(mutex);
+    frame++;
+    std::vector<uint32_t>target(entries.size());
+    uint64_t total = 0;
+    for(size_t i=0;i<entries.size();++i){
+      auto&e = entries[i];
+      auto const feedback = e.feedback->exchange(~0u,std::memory_order_relaxed);
+      if(feedback != ~0u)e.lastSampled = frame;
+      auto requested = e.requested;
+      if(!frameLocal && feedback != unknownTextureLevel)requested = std::min(requested,feedback);
+      target[i] = requested != ~0u?std::min(requested,e.tailLevel):frameLocal?e.tailLevel:e.level;
+      e.requested = ~0u;
+      total += levelSize(e,target[i]);
+    }
+
+    if(total > budget){
+      std::vector<uint32_t>order(entries.size());
+      for(uint32_t i=0;i<order.size();++i)order[i] = i;
+      if(!frameLocal)
+        std::stable_sort(order.begin(),order.end(),[&](uint32_t a,uint32_t b){return entries[a].lastSampled < entries[b].lastSampled;});
+      for(auto const i:order){
+        auto const&e = entries[i];
+        while(total > budget && target[i] < e.tailLevel){
+          total -= levelSize(e,target[i]);
+          target[i]++;
+          total += levelSize(e,target[i]);
+        }
+        if(total <= budget)break;
+      }
+    }
+
+    for(uint32_t i=0;i<entries.size();++i){
+      auto const&e = entries[i];
+      if(!e.data || target[i] == e.level)continue;
+      jobs.push_back({i,target[i],e.source,e.level,e.data});
+    }
+  }
+
+  // only update changes resident levels and updates are serialized, so the levels of jobs are still resident
+  std::vector<std::shared_ptr<std::vector<uint8_t>const>>levels(jobs.size());
+  for(size_t j=0;j<jobs.size();++j)
+    levels[j] = buildLevel(jobs[j].source,*jobs[j].resident,jobs[j].residentLevel,jobs[j].level);
+
+  std::lock_guard<std::mutex>lock(mutex);
+  bool changed = false;
+  for(size_t j=0;j<jobs.size();++j){
+    if(!levels[j])continue;
+    auto&e  = entries[jobs[j].texture];
+    e.data  = std::move(levels[j]);
+    e.level = jobs[j].level;
+    changed = true;
+  }
+  return changed;
+}
+
+/**
+ * @brief This function returns resident levels of all textures for the gpu memory.
+ *
+ * @param textures output textures, they keep their pixels alive
+ */
+void TextureResidency::getTextures(ResidentTextures&textures)const{
+  std::lock_guard<std::mutex>lock(mutex);
+  textures.textures.resize(entries.size());
+  textures.levels  .resize(entries.size());
+  for(size_t i=0;i<entries.size();++i){
+    auto const&e = entries[i];
+    auto&t     = textures.textures[i];
+    t.data     = e.data?e.data->data():nullptr;
+    t.width    = levelWidth (e.source,e.level);
+    t.height   = levelHeight(e.source,e.level);
+    t.channels = e.source.channels;
+    t.opaque   = e.opaque;
+    t.level    = e.level;
+    t.feedback = e.feedback.get();
+    textures.levels[i] = e.data;
+  }
+}
+
+uint32_t TextureResidency::getLevel(uint32_t texture)const{
+  std::lock_guard<std::mutex>lock(mutex);
+  return entries.at(texture).level;
+}
+
+/**
+ * @brief This function returns size of all resident levels in bytes.
+ */
+uint64_t TextureResidency::getResidentSize()const{
+  std::lock_guard<std::mutex>lock(mutex);
+  uint64_t res = 0;
+  for(auto const&e:entries)
+    if(e.data)res += e.data->size();
+  return res;
+}
+
+uint32_t TextureResidency::getNofTextures()const{
+  std::lock_guard<std::mutex>lock(mutex);
+  return (uint32_t)entries.size();
+}
+
+uint64_t TextureResidency::levelSize(Entry const&e,uint32_t level)const{
+  if(!e.data)return 0;
+  return (uint64_t)levelWidth(e.source,level)*levelHeight(e.source,level)*e.source.channels;
+}
@@ -0,0 +1,84 @@
+/*!
+ * @file
+ * @brief This file contains texture residency manager (texture streaming with memory budget).
+ *
+ * The manager owns pixels of all resident levels, images are read from their sources only when a level is built
+ * (decoded from encoded images of the model file or copied from pixels mapped from the model cache).
+ * The gpu sees one resident mip level of every texture. Small levels (mip tail) are always resident,
+ * so every texture can be sampled at any time. Requested levels are made resident by the next update,
+ * if they do not fit into the budget, textures that were not sampled for the longest time are coarsened first (LRU).
+ * Fragment stage writes sampling feedback (Texture::feedback): every sampled texture is used for the LRU order,
+ * the finest mip level computed by read_texture with footprint is requested like by request().
+ * Frame local manager chooses levels only from requests since the last update (no feedback, no history),
+ * so the resident levels of a frame do not depend on frames rendered before it.
+ * All functions can be called by several threads, levels are built without blocking the others.
+ */
+
+#pragma once
+
+#include<atomic>
+#include<cstdint>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<vector>
+
+#include<student/fwd.hpp>
+
+uint32_t const textureTailSize = 32;///< levels whose width and height are at most this size are always resident
+
+/**
+ * @brief This struct describes full resolution image (level 0) of texture that is not kept in memory.
+ */
+struct TextureSource{
+  uint32_t width    = 0;///< width of level 0
+  uint32_t height   = 0;///< height of level 0
+  uint32_t channels = 4;///< number of channels
+  std::function<bool(std::vector<uint8_t>&pixels)>load;///< reads level 0 (width*height*channels bytes), it can be called several times
+};
+
+/**
+ * @brief Resident levels of all textures at one time.
+ * Pixels stay valid while this object exists, even if the manager replaces the levels.
+ */
+struct ResidentTextures{
+  std::vector<Texture>textures;///< resident level of every texture (with sampling feedback)
+  std::vector<std::shared_ptr<std::vector<uint8_t>const>>levels;///< pixels of textures
+};
+
+/**
+ * @brief This class keeps resident mip levels of textures within memory budget.
+ */
+class TextureResidency{
+  public:
+    void     init(std::vector<TextureSource>const&sources,uint64_t budget,bool frameLocal = false);
+    void     init(TextureResidency const&other,uint64_t budget,bool frameLocal = false);
+    uint32_t requiredLevel(uint32_t texture,float pixels)const;
+    void     request(uint32_t texture,uint32_t level);
+    bool     update();
+    void     getTextures(ResidentTextures&textures)const;
+    uint32_t getLevel(uint32_t texture)const;
+    uint64_t getResidentSize()const;
+    uint32_t getNofTextures()const;
+  private:
+    /**
+     * @brief Residency state of one texture.
+     */
+    struct Entry{
+      TextureSource        source              ;///< full resolution image (level 0)
+      std::shared_ptr<std::vector<uint8_t>const>data;///< pixels of resident level (nullptr if the source cannot be read)
+      bool                 opaque      = false ;///< does every texel have alpha 1
+      uint32_t             level       = 0     ;///< resident level
+      uint32_t             tailLevel   = 0     ;///< the finest level of mip tail
+      uint32_t             requested   = ~0u   ;///< the finest level requested since the last update (~0u = no request)
+      uint64_t             lastSampled = 0     ;///< update in which the texture was sampled the last time
+      std::unique_ptr<std::atomic<uint32_t>>feedback;///< sampling feedback written by the fragment stage (see Texture::feedback)
+    };
+    uint64_t levelSize(Entry const&e,uint32_t level)const;
+    std::vector<Entry>entries           ;///< state of every texture
+    uint64_t          budget     = 0    ;///< memory budget of resident levels in bytes
+    uint64_t          frame      = 0    ;///< number of updates
+    bool              frameLocal = false;///< levels depend only on requests since the last update
+    mutable std::mutex mutex            ;///< guards all state, it is not held while levels are built
+    std::mutex        updateMutex       ;///< serializes init and update (only they change resident levels)
+};
@@ -181,6 +181,10 @@ void Window::processWindowEvent(SDL_Event const&event){
  */
 void Window::processEvents(){
   SDL_Event event;
+  if(waitForEvents && SDL_WaitEvent(&event)){
+    processWindowEvent(event);
+    processEvent(event);
+  }
   while (SDL_PollEvent(&event)){
     processWindowEvent(event);
     processEvent(event);
@@ -52,5 +52,6 @@ class Window{
     std::map<Uint32,EventCallback>eventCallbacks ;///< map of event callback function
     std::map<Uint8 ,EventCallback>windowCallbacks;///< map of event callback function for window event
     IdleCallback                  idleCallback   ;///< function that is called in mainloop when there are no events
+    bool                          waitForEvents  = false;///< should the main loop sleep until the next event (nothing to render)
 };
 
@@ -6,9 +6,32 @@
  */
 #include <student/drawModel.hpp>
 #include <student/gpu.hpp>
+#include <student/sceneGraph.hpp>
+
+#include <algorithm>
 
 ///\endcond
 
+namespace{
+
+/**
+ * @brief This function decides if mesh is opaque (depth prepass can be used for it).
+ * Opacity of textures is computed once by the model loader (Texture::opaque).
+ *
+ * @param model model
+ * @param mesh mesh of the model
+ *
+ * @return true if neither diffuse color nor diffuse texture has alpha < 1
+ */
+bool isOpaque(Model const&model,Mesh const&mesh){
+  if(mesh.diffuseTexture < 0)return mesh.diffuseColor.a >= 1.f;
+  if((size_t)mesh.diffuseTexture >= model.textures.size())return false;
+  auto const&t = model.textures[mesh.diffuseTexture];
+  return t.channels < 4 || t.opaque;
+}
+
+}
+
 /**
  * @brief This function prepares model into memory and creates command buffer
  *
@@ -16,18 +39,132 @@
  * @param commandBuffer command buffer
  * @param model model structure
  */
-//! [drawModel]
 void prepareModel(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model){
-  (void)mem;
-  (void)commandBuffer;
-  (void)model;
-  /// \todo Tato funkce připraví command buffer pro model a nastaví správně pamět grafické karty.<br>
-  /// Vaším úkolem je správně projít model a vložit vykreslovací příkazy do commandBufferu.
-  /// Zároveň musíte vložit do paměti textury, buffery a uniformní proměnné, které buffer command buffer využívat.
-  /// Bližší informace jsou uvedeny na hlavní stránce dokumentace a v testech.
+  prepareModel(mem,commandBuffer,model,SceneGraph(model.roots));
+}
+
+/**
+ * @brief This function prepares model like prepareModel, but its nodes are taken from already built scene graph.
+ * Draws are recorded by a linear scan of the graph, so the graph can be updated (SceneGraph::update) and the model prepared again.
+ *
+ * @param mem gpu memory
+ * @param commandBuffer command buffer
+ * @param model model structure
+ * @param scene scene graph of model.roots
+ */
+//! [drawModel]
+void prepareModel(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model,SceneGraph const&scene){
+  for(size_t i=0;i<model.buffers.size();++i)
+    mem.buffers[i] = model.buffers[i];
+  for(size_t i=0;i<model.textures.size();++i)
+    mem.textures[i] = model.textures[i];
+
+  auto&prg = mem.programs[drawModelProgram];
+  prg.vertexShader   = drawModel_vertexShader;
+  prg.fragmentShader = drawModel_fragmentShader;
+  prg.vs2fs[0]       = AttributeType::VEC3;
+  prg.vs2fs[1]       = AttributeType::VEC3;
+  prg.vs2fs[2]       = AttributeType::VEC2;
+  prg.vs2fs[3]       = AttributeType::UINT;
+
+  commandBuffer.nofCommands = 0;
+  pushClearCommand(commandBuffer,glm::vec4(0.1,0.15,0.1,1.),10e10f);
+
+  // nodes are in pre-order, so draws are in the same order as in recursive traversal
+  uint32_t drawId = 0;
+  for(auto const&node:scene.getNodes()){
+    if(node.mesh < 0)continue;
+    auto const&mesh = model.meshes.at(node.mesh);
+
+    VertexArray vao;
+    vao.indexBufferID   = mesh.indexBufferID;
+    vao.indexOffset     = mesh.indexOffset  ;
+    vao.indexType       = mesh.indexType    ;
+    vao.vertexAttrib[0] = mesh.position     ;
+    vao.vertexAttrib[1] = mesh.normal       ;
+    vao.vertexAttrib[2] = mesh.texCoord     ;
+    pushDrawCommand(commandBuffer,mesh.nofIndices,drawModelProgram,vao,!mesh.doubleSided);
+    auto&draw = commandBuffer.commands[commandBuffer.nofCommands-1].data.drawCommand;
+    draw.sortState = (uint32_t)(mesh.diffuseTexture+1);
+    // opaque meshes do not need blending, so they can be deferred into visibility buffer and sorted
+    if(isOpaque(model,mesh))draw.blend = BlendMode::OFF;
+
+    auto*uniforms = mem.uniforms + drawModelUniforms(drawId);
+    uniforms[DrawModelUniform::MODEL       ].m4 = node.worldMatrix;
+    uniforms[DrawModelUniform::INV_MODEL   ].m4 = glm::transpose(glm::inverse(node.worldMatrix));
+    uniforms[DrawModelUniform::DIFF_COLOR  ].v4 = mesh.diffuseColor;
+    uniforms[DrawModelUniform::TEXTURE_ID  ].u1 = mesh.diffuseTexture;
+    uniforms[DrawModelUniform::DOUBLE_SIDED].v1 = (float)mesh.doubleSided;
+    drawId++;
+  }
 }
 //! [drawModel]
 
+/**
+ * @brief This function prepares model like prepareModel, but opaque meshes are drawn twice.
+ * The first pass writes only depth of opaque meshes, the second pass draws all meshes and opaque ones use DepthFunc::EQUAL,
+ * so the fragment shader is executed once per visible pixel of opaque geometry.
+ * Draws of the depth prepass come first, so per draw uniforms of the second pass are moved behind them (see drawModelMeshes).
+ * If the doubled commands or uniforms do not fit, the model is drawn without prepass.
+ *
+ * @param mem gpu memory
+ * @param commandBuffer command buffer
+ * @param model model structure
+ * @param scene scene graph of model.roots
+ */
+void prepareModelDepthPrepass(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model,SceneGraph const&scene){
+  prepareModel(mem,commandBuffer,model,scene);
+
+  auto const meshes = drawModelMeshes(model,scene);
+  std::vector<uint32_t>prepass;
+  for(uint32_t d=0;d<meshes.size();++d)
+    if(isOpaque(model,model.meshes.at(meshes[d])))prepass.push_back(d);
+
+  auto const nofDraws   = (uint32_t)meshes .size();
+  auto const nofPrepass = (uint32_t)prepass.size();
+  if(!nofPrepass || commandBuffer.nofCommands+nofPrepass > CommandBuffer::maxCommands || drawModelUniforms(nofDraws+nofPrepass) > GPUMemory::maxUniforms)return;
+
+  // draws follow the clear command, they are moved (with their uniforms) behind the prepass
+  uint32_t const first = commandBuffer.nofCommands - nofDraws;
+  for(uint32_t d=nofDraws;d-->0;){
+    commandBuffer.commands[first+nofPrepass+d] = commandBuffer.commands[first+d];
+    std::copy_n(mem.uniforms+drawModelUniforms(d),(size_t)DrawModelUniform::NOF_UNIFORMS,mem.uniforms+drawModelUniforms(nofPrepass+d));
+  }
+  for(uint32_t p=0;p<nofPrepass;++p){
+    auto&shading = commandBuffer.commands[first+nofPrepass+prepass[p]];
+    auto&depth   = commandBuffer.commands[first+p];
+    depth = shading;
+    depth.data.drawCommand.colorWrite = false;
+    shading.data.drawCommand.depthFunc  = DepthFunc::EQUAL;
+    shading.data.drawCommand.depthWrite = false;
+    std::copy_n(mem.uniforms+drawModelUniforms(nofPrepass+prepass[p]),(size_t)DrawModelUniform::NOF_UNIFORMS,mem.uniforms+drawModelUniforms(p));
+  }
+  commandBuffer.nofCommands += nofPrepass;
+}
+
+/**
+ * @brief This function returns mesh of every draw recorded by prepareModel or prepareModelDepthPrepass.
+ *
+ * @param model model structure
+ * @param scene scene graph of model.roots
+ * @param depthPrepass was the model prepared by prepareModelDepthPrepass
+ *
+ * @return id of mesh of every draw command (in order of draws)
+ */
+std::vector<int32_t>drawModelMeshes(Model const&model,SceneGraph const&scene,bool depthPrepass){
+  std::vector<int32_t>res;
+  for(auto const&node:scene.getNodes())
+    if(node.mesh >= 0)res.push_back(node.mesh);
+  if(!depthPrepass)return res;
+
+  std::vector<int32_t>prepass;
+  for(auto const m:res)
+    if(isOpaque(model,model.meshes.at(m)))prepass.push_back(m);
+  if(prepass.empty() || prepass.size()+res.size()+1 > CommandBuffer::maxCommands || drawModelUniforms((uint32_t)(prepass.size()+res.size())) > GPUMemory::maxUniforms)return res;
+  prepass.insert(prepass.end(),res.begin(),res.end());
+  return prepass;
+}
+
 /**
  * @brief This function represents vertex shader of texture rendering method.
  *
@@ -10,8 +10,45 @@
 
 //void drawModel(Frame&frame,Model const&model,glm::mat4 const&proj,glm::mat4 const&view,glm::vec3 const&light,glm::vec3 const&camera);
 
+/**
+ * @brief Per draw uniforms of model rendering, draw i uses mem.uniforms[drawModelUniforms(i)+...].
+ * Uniforms 0-9 are shared by all draws (0 - projection*view, 1 - light, 2 - camera).
+ */
+namespace DrawModelUniform{
+enum{
+  MODEL        = 0,///< model matrix
+  INV_MODEL       ,///< transposed inverse of model matrix
+  DIFF_COLOR      ,///< diffuse color
+  TEXTURE_ID      ,///< diffuse texture id (or -1)
+  DOUBLE_SIDED    ,///< 1.f if the mesh is double sided
+  NOF_UNIFORMS    ,///< number of per draw uniforms
+};
+}
+
+int32_t  const drawModelProgram       = 0 ;///< program used by model rendering
+uint32_t const drawModelUniformOffset = 10;///< first per draw uniform
+
+/**
+ * @brief This function returns the first uniform of draw.
+ *
+ * @param drawId id of draw command (without clear commands)
+ *
+ * @return index into mem.uniforms
+ */
+inline uint32_t drawModelUniforms(uint32_t drawId){
+  return drawModelUniformOffset + drawId*DrawModelUniform::NOF_UNIFORMS;
+}
+
+class SceneGraph;
+
 void prepareModel(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model);
 
+void prepareModel(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model,SceneGraph const&scene);
+
+void prepareModelDepthPrepass(GPUMemory&mem,CommandBuffer&commandBuffer,Model const&model,SceneGraph const&scene);
+
+std::vector<int32_t>drawModelMeshes(Model const&model,SceneGraph const&scene,bool depthPrepass = false);
+
 void drawModel_vertexShader(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si);
 
 void drawModel_fragmentShader(OutFragment&outFragment,InFragment const&inFragment,ShaderInterface const&si);
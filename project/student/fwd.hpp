@@ -8,12 +8,14 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <atomic>
 #include <cstdint>
 #include <vector>
 
 //#define MAKE_STUDENT_RELEASE
 
 uint32_t const maxAttributes = 4;///< maximum number of vertex/fragment attributes
+uint32_t const unknownTextureLevel = 0xfffffffe;///< sampling feedback of read_texture without texel footprint (see Texture::feedback)
 
 /**
  * @brief This struct represent a texture
@@ -24,6 +26,9 @@ struct Texture{
   uint32_t       width    = 0      ;///< width of the texture
   uint32_t       height   = 0      ;///< height of the texture
   uint32_t       channels = 3      ;///< number of channels of the texture
+  bool           opaque   = false  ;///< does every texel have alpha 1 (computed by model loader, false = unknown)
+  uint32_t       level    = 0      ;///< mip level of data, level 0 has roughly (width<<level) x (height<<level) texels (see TextureResidency)
+  std::atomic<uint32_t>*feedback = nullptr;///< sampling feedback - the finest mip level computed by read_texture (unknownTextureLevel without footprint, ~0u = not sampled), nullptr = no feedback
 };
 //! [Texture]
 
@@ -41,9 +46,45 @@ enum class AttributeType{
   UVEC2 = 8+2, ///< 2x 32-bit unsigned int
   UVEC3 = 8+3, ///< 3x 32-bit unsigned int
   UVEC4 = 8+4, ///< 4x 32-bit unsigned int
+  SNORM8       = 16+1, ///< 1x normalized 8-bit signed int, read as float in [-1,1]
+  SNORM8_VEC2  = 16+2, ///< 2x normalized 8-bit signed int
+  SNORM8_VEC3  = 16+3, ///< 3x normalized 8-bit signed int
+  SNORM8_VEC4  = 16+4, ///< 4x normalized 8-bit signed int
+  UNORM8       = 24+1, ///< 1x normalized 8-bit unsigned int, read as float in [0,1]
+  UNORM8_VEC2  = 24+2, ///< 2x normalized 8-bit unsigned int
+  UNORM8_VEC3  = 24+3, ///< 3x normalized 8-bit unsigned int
+  UNORM8_VEC4  = 24+4, ///< 4x normalized 8-bit unsigned int
+  SNORM16      = 32+1, ///< 1x normalized 16-bit signed int, read as float in [-1,1]
+  SNORM16_VEC2 = 32+2, ///< 2x normalized 16-bit signed int
+  SNORM16_VEC3 = 32+3, ///< 3x normalized 16-bit signed int
+  SNORM16_VEC4 = 32+4, ///< 4x normalized 16-bit signed int
+  UNORM16      = 40+1, ///< 1x normalized 16-bit unsigned int, read as float in [0,1]
+  UNORM16_VEC2 = 40+2, ///< 2x normalized 16-bit unsigned int
+  UNORM16_VEC3 = 40+3, ///< 3x normalized 16-bit unsigned int
+  UNORM16_VEC4 = 40+4, ///< 4x normalized 16-bit unsigned int
+  HALF         = 48+1, ///< 1x 16-bit float
+  HALF_VEC2    = 48+2, ///< 2x 16-bit floats
+  HALF_VEC3    = 48+3, ///< 3x 16-bit floats
+  HALF_VEC4    = 48+4, ///< 4x 16-bit floats
 };
 //! [AttributeType]
 
+/**
+ * @brief This function returns number of components of attribute type (lowest 3 bits).
+ */
+inline uint32_t attributeTypeComponents(AttributeType type){
+  return (uint32_t)type & 7u;
+}
+
+/**
+ * @brief This function returns size of attribute type in vertex buffer (in bytes).
+ * Normalized and half-float types are only read by vertex puller, they are converted to floats.
+ */
+inline uint32_t attributeTypeSize(AttributeType type){
+  uint32_t const componentSize[] = {4,4,1,1,2,2,2,0};
+  return componentSize[((uint32_t)type >> 3) & 7u]*attributeTypeComponents(type);
+}
+
 /**
  * @brief This union represents one vertex/fragment attribute
  */
@@ -135,6 +176,8 @@ enum class IndexType{
 //! [IndexType]
 
 
+uint32_t const maxDrawConstants = 8;///< size of draw-local constant block (see DrawPrologue)
+
 /**
  * @brief This enum represents constant shader interface common for all shaders.
  *
@@ -144,8 +187,9 @@ enum class IndexType{
  */
 //! [ShaderInterface]
 struct ShaderInterface{
-  Uniform const*uniforms = nullptr; ///< uniform variables
-  Texture const*textures = nullptr; ///< textures
+  Uniform const*uniforms      = nullptr; ///< uniform variables
+  Texture const*textures      = nullptr; ///< textures
+  Uniform const*drawConstants = nullptr; ///< draw-local constants written by Program::prologue (maxDrawConstants)
 };
 //! [ShaderInterface]
 
@@ -177,6 +221,22 @@ using FragmentShader = void(*)(
     ShaderInterface const&si         );
 //! [FragmentShader]
 
+/**
+ * @brief Function type for draw prologue
+ * Prologue is executed once per draw before any vertex shader, it computes values derived from uniforms
+ * (e.g. projection*view matrix) so shaders do not recompute them for every vertex or fragment.
+ *
+ * @param drawConstants output - draw-local constant block (maxDrawConstants), shaders read it as si.drawConstants
+ * @param si shader interface of the draw (uniforms and textures)
+ * @param drawID id of the draw (gl_DrawID)
+ */
+//! [DrawPrologue]
+using DrawPrologue = void(*)(
+    Uniform              *drawConstants,
+    ShaderInterface const&si           ,
+    uint32_t              drawID       );
+//! [DrawPrologue]
+
 /**
  * @brief This struct describes location of one vertex attribute.
  */
@@ -206,18 +266,27 @@ struct VertexArray{
  * @brief This structu represents a program.
  * Vertex Shader is executed on every InVertex.
  * Fragment Shader is executed on every rasterized InFragment.
+ * Prologue (if any) is executed once per draw before vertex shaders.
+ * Program without fragment shader draws only depth (see DrawCommand::colorWrite).
  */
 //! [Program]
 struct Program{
   VertexShader   vertexShader   = nullptr; ///< vertex shader
   FragmentShader fragmentShader = nullptr; ///< fragment shader
+  DrawPrologue   prologue       = nullptr; ///< optional per draw prologue
   AttributeType  vs2fs[maxAttributes] = {AttributeType::EMPTY}; ///< which attributes are interpolated from vertex shader to fragment shader
 };
 //! [Program]
 
+uint32_t const frameTileSize = 8;///< width and height of tile of tiled frame (in pixels)
+
 /**
  * @brief This structure represents a frame.
  * Frame (or framebuffer) is used as output of rendering.
+ * Multisampled frame (samples > 1) stores all samples of one pixel next to each other.
+ * Tiled frame stores pixels in frameTileSize x frameTileSize tiles, color and depth of one tile are next to each other
+ * in one allocation (gpu_tiledFrameSize), depth points behind color of the first tile.
+ * Multisampled and tiled frames have to be resolved (gpu_resolve) before they are presented.
  */
 //! [Frame]
 struct Frame{
@@ -226,6 +295,8 @@ struct Frame{
   uint32_t channels = 4      ; ///< number of color channels
   uint32_t width    = 0      ; ///< width of frame
   uint32_t height   = 0      ; ///< height of frame
+  uint32_t samples  = 1      ; ///< number of samples per pixel (1 or 4)
+  bool     tiled    = false  ; ///< are pixels stored in tiles?
 };
 //! [Frame]
 
@@ -274,6 +345,45 @@ struct ClearCommand{
 };
 //! [ClearCommand]
 
+/**
+ * @brief This enum represents blending of fragment color with color in framebuffer.
+ */
+//! [BlendMode]
+enum class BlendMode{
+  AUTO    , ///< fragments with alpha < 1 are alpha blended, depth is written only by fragments with alpha > 0.5
+  OFF     , ///< fragment color replaces framebuffer color
+  ALPHA   , ///< src*src.a + dst*(1-src.a)
+  ADDITIVE, ///< src*src.a + dst
+};
+//! [BlendMode]
+
+/**
+ * @brief This enum represents depth test comparison of fragment depth with depth in framebuffer.
+ */
+//! [DepthFunc]
+enum class DepthFunc{
+  NEVER   , ///< depth test never passes
+  LESS    , ///< passes if fragment depth <  framebuffer depth
+  LEQUAL  , ///< passes if fragment depth <= framebuffer depth
+  EQUAL   , ///< passes if fragment depth == framebuffer depth
+  GREATER , ///< passes if fragment depth >  framebuffer depth
+  GEQUAL  , ///< passes if fragment depth >= framebuffer depth
+  NOTEQUAL, ///< passes if fragment depth != framebuffer depth
+  ALWAYS  , ///< depth test always passes
+};
+//! [DepthFunc]
+
+/**
+ * @brief This enum represents how vertices of draw command form triangles.
+ */
+//! [Topology]
+enum class Topology{
+  TRIANGLES     , ///< every 3 vertices form a triangle
+  TRIANGLE_STRIP, ///< every vertex forms a triangle with 2 previous vertices (odd triangles swap first two vertices to keep winding)
+  TRIANGLE_FAN  , ///< every vertex forms a triangle with the first and the previous vertex
+};
+//! [Topology]
+
 /**
  * @brief This structure represents draw command.
  * Draw command issues draw operation on the GPU.
@@ -284,6 +394,15 @@ struct DrawCommand{
   uint32_t    nofVertices     = 0    ; ///< number of vertices to draw
   bool        backfaceCulling = false; ///< is culling of backfacing triangles enabled?
   VertexArray vao                    ; ///< active vertex array (input/ triangles)
+  BlendMode   blend      = BlendMode::AUTO  ; ///< blending of fragments
+  bool        depthTest  = true             ; ///< is depth test enabled? (disabled depth test does not write depth)
+  bool        depthWrite = true             ; ///< is depth write enabled?
+  DepthFunc   depthFunc  = DepthFunc::LEQUAL; ///< depth test comparison
+  bool        colorWrite = true             ; ///< is color write enabled? (false = depth-only draw, fragment shader is not executed)
+  uint32_t    sortState  = 0                ; ///< state of draw (e.g. texture), draws with the same state are adjacent after sorting (SubmitFlags::SORT_DRAWS)
+  float       sortDepth  = 0.f              ; ///< distance of draw from camera, draws of the same state are sorted front-to-back (SubmitFlags::SORT_DRAWS)
+  Topology    topology   = Topology::TRIANGLES; ///< how vertices form triangles
+  bool        primitiveRestart = false      ; ///< does the maximal value of index type (0xff, 0xffff, 0xffffffff) start a new strip/fan/list (indexed draws only)
 };
 //! [DrawCommand]
 
@@ -384,6 +503,20 @@ inline void pushDrawCommand(
 
 
 
+uint32_t const maxMeshLods = 4;///< maximal number of levels of detail of a mesh (including the mesh itself)
+
+/**
+ * @brief This struct represents simplified level of detail of a mesh.
+ * It uses vertices of the mesh, only indices are different.
+ */
+struct MeshLod{
+  int32_t      indexBufferID  = -1               ;///< index of buffer used for indices
+  size_t       indexOffset    = 0                ;///< offset into index buffer
+  IndexType    indexType      = IndexType::UINT32;///< type of indices
+  uint32_t     nofIndices     = 0                ;///< number of indices
+  float        error          = 0.f              ;///< simplification error in model space
+};
+
 /**
  * @brief This struct represents a mesh
  */
@@ -399,6 +532,9 @@ struct Mesh{
   glm::vec4    diffuseColor   = glm::vec4(1.f)   ;///< default diffuseColor (if there is no texture)
   int          diffuseTexture = -1               ;///< diffuse texture or -1 (no texture)
   bool         doubleSided    = false            ;///< double sided material
+  glm::vec4    bounds         = glm::vec4(0.f)   ;///< bounding sphere in model space (center, radius), valid if radius > 0
+  uint32_t     nofLods        = 0                ;///< number of simplified levels of detail
+  MeshLod      lods[maxMeshLods-1]               ;///< simplified levels of detail (from finer to coarser)
 };
 //! [Mesh]
 
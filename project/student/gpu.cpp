@@ -6,28 +6,92 @@
  */
 
 #include <student/gpu.hpp>
+#include <student/profiler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IZG_RESOLVE_SSE2
+#endif
+
+uint64_t gpu_tiledFrameSize(uint32_t width, uint32_t height, uint32_t samples)
+{
+	const uint64_t tilesX = (width + frameTileSize - 1) / frameTileSize;
+	const uint64_t tilesY = (height + frameTileSize - 1) / frameTileSize;
+	return tilesX * tilesY * frameTileSize * frameTileSize * samples * (4 + sizeof(float));
+}
 
-void clear(GPUMemory &mem, ClearCommand cmd)
+/**
+ * @brief This function returns index of the first sample of pixel.
+ * Color of sample i is at color[4*i], depth is at depth[i].
+ * Tiled frame: color of all samples of a tile is followed by depth of all samples of the tile,
+ * so index of tile t starts at t * 2 * (pixels per tile) * samples.
+ *
+ * @param frame frame
+ * @param x x coordinate of pixel
+ * @param y y coordinate of pixel
+ *
+ * @return index of sample 0 of pixel
+ */
+inline uint64_t sampleIndex(Frame const &frame, uint32_t x, uint32_t y)
+{
+	if (!frame.tiled)
+		return (static_cast<uint64_t>(y) * frame.width + x) * frame.samples;
+	const uint64_t tilesX = (frame.width + frameTileSize - 1) / frameTileSize;
+	const uint64_t tile = (y / frameTileSize) * tilesX + x / frameTileSize;
+	const uint64_t pixel = (y % frameTileSize) * frameTileSize + x % frameTileSize;
+	return (tile * 2 * frameTileSize * frameTileSize + pixel) * frame.samples;
+}
+
+void gpu_clear(Frame const &frame, ClearCommand const &cmd)
 {
-	if (cmd.clearColor)
+	// linear frame is one run of samples, tiled frame has one run per tile
+	uint64_t nofRuns = 1;
+	uint64_t runLength = static_cast<uint64_t>(frame.width) * frame.height * frame.samples;
+	uint64_t runStride = 0;
+	if (frame.tiled)
 	{
-		for (uint64_t i = 0; i + 4 < 4 * (mem.framebuffer.height * mem.framebuffer.width); i += 4)
-		{
-			mem.framebuffer.color[i] = static_cast<uint8_t>(cmd.color.r * 255.f);
-			mem.framebuffer.color[i + 1] = static_cast<uint8_t>(cmd.color.g * 255.f);
-			mem.framebuffer.color[i + 2] = static_cast<uint8_t>(cmd.color.b * 255.f);
-			mem.framebuffer.color[i + 3] = static_cast<uint8_t>(cmd.color.a * 255.f);
-		}
+		nofRuns = gpu_tiledFrameSize(frame.width, frame.height, frame.samples) / (frameTileSize * frameTileSize * frame.samples * (4 + sizeof(float)));
+		runLength = frameTileSize * frameTileSize * frame.samples;
+		runStride = 2 * runLength;
 	}
-	if (cmd.clearDepth)
+
+	const uint8_t color[4] = {
+		static_cast<uint8_t>(cmd.color.r * 255.f),
+		static_cast<uint8_t>(cmd.color.g * 255.f),
+		static_cast<uint8_t>(cmd.color.b * 255.f),
+		static_cast<uint8_t>(cmd.color.a * 255.f),
+	};
+
+	for (uint64_t r = 0; r < nofRuns; ++r)
 	{
-		for (int i = 0; i < (mem.framebuffer.height * mem.framebuffer.width); i++)
+		if (cmd.clearColor)
+		{
+			uint8_t *c = frame.color + 4 * r * runStride;
+			for (uint64_t i = 0; i < runLength; ++i)
+				std::memcpy(c + 4 * i, color, 4);
+		}
+		if (cmd.clearDepth)
 		{
-			mem.framebuffer.depth[i] = cmd.depth;
+			float *d = frame.depth + r * runStride;
+			std::fill(d, d + runLength, cmd.depth);
 		}
 	}
 }
 
+void clear(GPUMemory &mem, ClearCommand cmd)
+{
+	PROFILE_STAGE(CLEAR);
+	gpu_clear(mem.framebuffer, cmd);
+}
+
 void computeVertexID(GPUMemory &mem, VertexArray &vao, uint32_t *shaderInvocation, InVertex &inVertex)
 {
 	if (vao.indexBufferID < 0)
@@ -58,6 +122,72 @@ void computeVertexID(GPUMemory &mem, VertexArray &vao, uint32_t *shaderInvocatio
 	}
 }
 
+/**
+ * @brief This function converts 16-bit float to float (denormals, infinities and NaNs included).
+ */
+inline float halfToFloat(uint16_t h)
+{
+	const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+	const uint32_t exponent = (h >> 10) & 0x1fu;
+	const uint32_t mantissa = h & 0x3ffu;
+	uint32_t bits;
+	if (exponent == 0x1fu)
+		bits = sign | 0x7f800000u | (mantissa << 13);
+	else if (exponent != 0)
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	else
+	{
+		// zero or denormal - mantissa * 2^-24
+		float f = static_cast<float>(mantissa) * (1.f / 16777216.f);
+		std::memcpy(&bits, &f, sizeof(bits));
+		bits |= sign;
+	}
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+/**
+ * @brief This function reads n normalized integers (signed: max(v/MAX,-1), unsigned: v/MAX) into float components of attribute.
+ */
+template <typename T>
+inline void readNormalized(Attribute &attribute, const uint8_t *data, uint32_t n)
+{
+	constexpr float scale = 1.f / static_cast<float>(std::numeric_limits<T>::max());
+	for (uint32_t k = 0; k < n; ++k)
+	{
+		T v;
+		std::memcpy(&v, data + k * sizeof(T), sizeof(T));
+		attribute.v4[k] = std::numeric_limits<T>::is_signed ? std::max(static_cast<float>(v) * scale, -1.f) : static_cast<float>(v) * scale;
+	}
+}
+
+inline void readHalf(Attribute &attribute, const uint8_t *data, uint32_t n)
+{
+	for (uint32_t k = 0; k < n; ++k)
+	{
+		uint16_t v;
+		std::memcpy(&v, data + k * sizeof(v), sizeof(v));
+		attribute.v4[k] = halfToFloat(v);
+	}
+}
+
+/**
+ * @brief This function returns primitive restart index of index type (its maximal value).
+ */
+inline uint32_t restartIndex(IndexType type)
+{
+	switch (type)
+	{
+	case IndexType::UINT8:
+		return 0xffu;
+	case IndexType::UINT16:
+		return 0xffffu;
+	default:
+		return 0xffffffffu;
+	}
+}
+
 void getAttr(GPUMemory &mem, VertexAttrib *vertexAttrib, InVertex &inVertex)
 {
 	for (uint32_t i = 0; i < maxAttributes; i++)
@@ -103,6 +233,44 @@ void getAttr(GPUMemory &mem, VertexAttrib *vertexAttrib, InVertex &inVertex)
 		case AttributeType::UVEC4:
 			inVertex.attributes[i].u4 = *reinterpret_cast<const glm::uvec4 *>(attrData);
 			break;
+
+		case AttributeType::SNORM8:
+		case AttributeType::SNORM8_VEC2:
+		case AttributeType::SNORM8_VEC3:
+		case AttributeType::SNORM8_VEC4:
+			readNormalized<int8_t>(inVertex.attributes[i], attrData, attributeTypeComponents(attrib.type));
+			break;
+
+		case AttributeType::UNORM8:
+		case AttributeType::UNORM8_VEC2:
+		case AttributeType::UNORM8_VEC3:
+		case AttributeType::UNORM8_VEC4:
+			readNormalized<uint8_t>(inVertex.attributes[i], attrData, attributeTypeComponents(attrib.type));
+			break;
+
+		case AttributeType::SNORM16:
+		case AttributeType::SNORM16_VEC2:
+		case AttributeType::SNORM16_VEC3:
+		case AttributeType::SNORM16_VEC4:
+			readNormalized<int16_t>(inVertex.attributes[i], attrData, attributeTypeComponents(attrib.type));
+			break;
+
+		case AttributeType::UNORM16:
+		case AttributeType::UNORM16_VEC2:
+		case AttributeType::UNORM16_VEC3:
+		case AttributeType::UNORM16_VEC4:
+			readNormalized<uint16_t>(inVertex.attributes[i], attrData, attributeTypeComponents(attrib.type));
+			break;
+
+		case AttributeType::HALF:
+		case AttributeType::HALF_VEC2:
+		case AttributeType::HALF_VEC3:
+		case AttributeType::HALF_VEC4:
+			readHalf(inVertex.attributes[i], attrData, attributeTypeComponents(attrib.type));
+			break;
+
+		default:
+			break;
 		}
 	}
 }
@@ -124,8 +292,12 @@ void TriangleAssembly(GPUMemory &mem, Triangle &triangle, Program const &prg, Ve
 
 		uint32_t correctId = i + tId * 3;
 
-		VertexAssembly(mem, vao, inVertex, &correctId, &draw_id);
+		{
+			PROFILE_STAGE(VERTEX_PULL);
+			VertexAssembly(mem, vao, inVertex, &correctId, &draw_id);
+		}
 
+		PROFILE_STAGE(VERTEX_SHADER);
 		vs(triangle.points[i], inVertex, si);
 	}
 }
@@ -149,257 +321,1633 @@ void viewportTransformation(Triangle &triangle, uint32_t width, uint32_t height)
 	}
 }
 
-void barycentric(const glm::vec2 &pos, const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c, glm::vec3 &bar)
+/**
+ * @brief Screen space plane equations of interpolated quantities of a triangle.
+ * Every plane is (d/dx, d/dy, value at origin), plane 0 is depth (z), plane 1 is 1/w
+ * and the rest are components of interpolated attributes divided by w (EMPTY and integer attributes have no plane).
+ */
+struct TrianglePlanes
 {
-	glm::vec4 pos_4 = {pos.x, pos.y, 0, 0};
-	const glm::vec2 v0 = b - a;
-	const glm::vec2 v1 = c - a;
-	const glm::vec2 v2 = pos_4 - a;
-
-	const float d00 = glm::dot(v0, v0);
-	const float d01 = glm::dot(v0, v1);
-	const float d11 = glm::dot(v1, v1);
-	const float d20 = glm::dot(v2, v0);
-	const float d21 = glm::dot(v2, v1);
-	const float denom = d00 * d11 - d01 * d01;
-
-	bar.y = (d11 * d20 - d01 * d21) / denom;
-	bar.z = (d00 * d21 - d01 * d20) / denom;
-	bar.x = 1.0f - bar.y - bar.z;
-}
-
-template <typename T>
-T interpolateAttribute(const T &a, const T &b, const T &c, const glm::vec3 &bary)
+	glm::vec2 origin;                              ///< screen position of the first vertex
+	uint32_t nofPlanes = 0;                        ///< number of used planes
+	glm::vec3 planes[2 + 4 * maxAttributes];       ///< plane equations
+	uint32_t firstPlane[maxAttributes];            ///< first plane of attribute
+	Attribute const *flat = nullptr;               ///< attributes of the first vertex (integer attributes are not interpolated)
+	AttributeType const *vs2fs = nullptr;          ///< types of attributes
+};
+
+uint32_t nofComponents(AttributeType type)
 {
-	return a * bary.x + b * bary.y + c * bary.z;
+	switch (type)
+	{
+	case AttributeType::FLOAT:
+		return 1;
+	case AttributeType::VEC2:
+		return 2;
+	case AttributeType::VEC3:
+		return 3;
+	case AttributeType::VEC4:
+		return 4;
+	default:
+		return 0;
+	}
 }
 
-void interpolate(InFragment &in, Triangle t, glm::vec3 bar, AttributeType *vs2fs)
+/**
+ * @brief This function computes plane equations of triangle, it is done once per triangle.
+ *
+ * @param planes output plane equations
+ * @param t triangle in screen space
+ * @param vs2fs types of attributes (nullptr = depth only)
+ *
+ * @return false if the triangle is degenerate (it has zero area)
+ */
+bool setupPlanes(TrianglePlanes &planes, Triangle const &t, AttributeType const *vs2fs)
 {
-	const glm::vec4 a = t.points[0].gl_Position;
-	const glm::vec4 b = t.points[1].gl_Position;
-	const glm::vec4 c = t.points[2].gl_Position;
+	const glm::vec4 &a = t.points[0].gl_Position;
+	const glm::vec4 &b = t.points[1].gl_Position;
+	const glm::vec4 &c = t.points[2].gl_Position;
+	const glm::vec2 e1 = glm::vec2(b) - glm::vec2(a);
+	const glm::vec2 e2 = glm::vec2(c) - glm::vec2(a);
+	const float det = e1.x * e2.y - e2.x * e1.y;
+	if (det == 0.f)
+		return false;
+	const float invDet = 1.f / det;
+
+	const auto plane = [&](float q0, float q1, float q2) {
+		const float d1 = q1 - q0;
+		const float d2 = q2 - q0;
+		return glm::vec3((d1 * e2.y - d2 * e1.y) * invDet, (e1.x * d2 - e2.x * d1) * invDet, q0);
+	};
+
+	planes.origin = glm::vec2(a);
+	planes.planes[0] = plane(a.z, b.z, c.z);
+	planes.nofPlanes = 1;
+	planes.vs2fs = vs2fs;
+	if (!vs2fs)
+		return true;
+
+	const glm::vec3 invW = {1.f / a.w, 1.f / b.w, 1.f / c.w};
+	planes.planes[planes.nofPlanes++] = plane(invW.x, invW.y, invW.z);
 
 	const Attribute *const A = t.points[0].attributes;
 	const Attribute *const B = t.points[1].attributes;
 	const Attribute *const C = t.points[2].attributes;
+	planes.flat = A;
+	for (uint32_t i = 0; i < maxAttributes; ++i)
+	{
+		planes.firstPlane[i] = planes.nofPlanes;
+		for (uint32_t k = 0; k < nofComponents(vs2fs[i]); ++k)
+			planes.planes[planes.nofPlanes++] = plane(A[i].v4[k] * invW.x, B[i].v4[k] * invW.y, C[i].v4[k] * invW.z);
+	}
+	return true;
+}
+
+inline float evaluatePlane(glm::vec3 const &plane, glm::vec2 const &d)
+{
+	return plane.z + plane.x * d.x + plane.y * d.y;
+}
 
-	in.gl_FragCoord.z = a.z * bar.x + b.z * bar.y + c.z * bar.z;
+/**
+ * @brief This function computes depth of fragment (depth-only draws use it instead of fragmentAssembly).
+ * Depth prepass followed by DepthFunc::EQUAL pass relies on both depths being the same.
+ *
+ * @param pos position of fragment
+ * @param planes plane equations of triangle
+ *
+ * @return depth of fragment
+ */
+inline float fragmentDepth(glm::vec2 pos, TrianglePlanes const &planes)
+{
+	return evaluatePlane(planes.planes[0], pos - planes.origin);
+}
 
-	const float s = (bar.x / a.w) + (bar.y / b.w) + (bar.z / c.w);
+/**
+ * @brief This function interpolates depth and attributes of fragment using plane equations of triangle.
+ * Attributes are perspective correct, it costs one reciprocal per fragment and one multiply-add per component.
+ *
+ * @param in output fragment
+ * @param pos position of fragment
+ * @param planes plane equations of triangle
+ */
+void fragmentAssembly(InFragment &in, glm::vec2 pos, TrianglePlanes const &planes)
+{
+	const glm::vec2 d = pos - planes.origin;
+	in.gl_FragCoord.x = pos.x;
+	in.gl_FragCoord.y = pos.y;
+	in.gl_FragCoord.z = evaluatePlane(planes.planes[0], d);
 
-	const glm::vec3 perspectiveBary = {(bar.x / (a.w * s)), (bar.y / (b.w * s)), (bar.z / (c.w * s))};
+	const float w = 1.f / evaluatePlane(planes.planes[1], d);
 
 	for (uint32_t i = 0; i < maxAttributes; i++)
 	{
-		switch (vs2fs[i])
+		switch (planes.vs2fs[i])
 		{
-		case AttributeType::FLOAT:
-			in.attributes[i].v1 = interpolateAttribute(A[i].v1, B[i].v1, C[i].v1, perspectiveBary);
+		case AttributeType::EMPTY:
 			break;
 
+		case AttributeType::FLOAT:
 		case AttributeType::VEC2:
-			in.attributes[i].v2 = interpolateAttribute(A[i].v2, B[i].v2, C[i].v2, perspectiveBary);
-			break;
-
 		case AttributeType::VEC3:
-			in.attributes[i].v3 = interpolateAttribute(A[i].v3, B[i].v3, C[i].v3, perspectiveBary);
-			break;
-
 		case AttributeType::VEC4:
-			in.attributes[i].v4 = interpolateAttribute(A[i].v4, B[i].v4, C[i].v4, perspectiveBary);
-			break;
-
-		case AttributeType::UINT:
-			in.attributes[i].u1 = A[i].u1;
+		{
+			const glm::vec3 *p = planes.planes + planes.firstPlane[i];
+			for (uint32_t k = 0; k < nofComponents(planes.vs2fs[i]); ++k)
+				in.attributes[i].v4[k] = evaluatePlane(p[k], d) * w;
 			break;
+		}
 
-		case AttributeType::UVEC2:
-			in.attributes[i].u2 = A[i].u2;
+		default:
+			in.attributes[i] = planes.flat[i];
 			break;
+		}
+	}
+}
 
-		case AttributeType::UVEC3:
-			in.attributes[i].u3 = A[i].u3;
-			break;
+/**
+ * @brief Per fragment operations of one sample (depth test, blending, write).
+ *
+ * @param framebuffer frame
+ * @param outF output of fragment shader
+ * @param inDepth depth of the sample
+ * @param idx index of the sample in color/depth buffer
+ */
+using PerFragmentOperations = void (*)(Frame const &framebuffer, OutFragment const &outF, float inDepth, uint64_t idx);
 
-		case AttributeType::UVEC4:
-			in.attributes[i].u4 = A[i].u4;
-			break;
-		}
+template <DepthFunc F>
+inline bool depthCompare(float inDepth, float depth)
+{
+	switch (F)
+	{
+	case DepthFunc::NEVER:
+		return false;
+	case DepthFunc::LESS:
+		return inDepth < depth;
+	case DepthFunc::LEQUAL:
+		return inDepth <= depth;
+	case DepthFunc::EQUAL:
+		return inDepth == depth;
+	case DepthFunc::GREATER:
+		return inDepth > depth;
+	case DepthFunc::GEQUAL:
+		return inDepth >= depth;
+	case DepthFunc::NOTEQUAL:
+		return inDepth != depth;
+	default:
+		return true;
 	}
 }
 
-void fragmentAssembly(InFragment &in, glm::vec2 pos, Triangle t, AttributeType *vs2fs)
+inline glm::vec4 readColor(Frame const &framebuffer, uint64_t idx)
 {
-	auto a = t.points[0], b = t.points[1], c = t.points[2];
+	const uint8_t *c = framebuffer.color + 4 * idx;
+	return glm::vec4(c[0], c[1], c[2], c[3]) / 255.f;
+}
 
-	in.gl_FragCoord.x = pos.x;
-	in.gl_FragCoord.y = pos.y;
+inline void writeColor(Frame const &framebuffer, uint64_t idx, glm::vec4 const &color)
+{
+	uint8_t *c = framebuffer.color + 4 * idx;
+	c[0] = static_cast<uint8_t>(color.r * 255.f);
+	c[1] = static_cast<uint8_t>(color.g * 255.f);
+	c[2] = static_cast<uint8_t>(color.b * 255.f);
+	c[3] = static_cast<uint8_t>(color.a * 255.f);
+}
+
+/**
+ * @brief This function converts output of fragment shader to RGBA8 (clamped, truncated like writeColor).
+ *
+ * @return color in the byte order of frame
+ */
+inline uint32_t packColor(glm::vec4 const &color)
+{
+	const glm::vec4 c = glm::clamp(color, glm::vec4(0.f), glm::vec4(1.f)) * 255.f;
+	const uint8_t rgba[4] = {static_cast<uint8_t>(c.r), static_cast<uint8_t>(c.g), static_cast<uint8_t>(c.b), static_cast<uint8_t>(c.a)};
+	uint32_t packed;
+	std::memcpy(&packed, rgba, sizeof(packed));
+	return packed;
+}
+
+/**
+ * @brief Per fragment operations of one sample of opaque draw (BlendMode::OFF).
+ * The color is packed once per fragment, every covered sample is only depth compare and store.
+ */
+using OpaqueOperations = void (*)(Frame const &framebuffer, uint32_t color, float inDepth, uint64_t idx);
 
-	glm::vec3 bar{0, 0, 0};
+/**
+ * @brief Per fragment operations selected for the state of draw command.
+ */
+struct FragmentOperations
+{
+	PerFragmentOperations pfo = nullptr; ///< operations of one sample
+	OpaqueOperations opaque = nullptr;   ///< operations of one sample with packed color (BlendMode::OFF) or nullptr
+};
+
+template <DepthFunc F, bool DEPTH_WRITE>
+void opaqueOperations(Frame const &framebuffer, uint32_t color, float inDepth, uint64_t idx)
+{
+	if (!depthCompare<F>(inDepth, framebuffer.depth[idx]))
+		return;
 
-	barycentric(pos, a.gl_Position, b.gl_Position, c.gl_Position, bar);
+	if (DEPTH_WRITE)
+		framebuffer.depth[idx] = inDepth;
 
-	interpolate(in, t, bar, vs2fs);
+	std::memcpy(framebuffer.color + 4 * idx, &color, sizeof(color));
 }
 
-void perFragmentOperations(Frame const &framebuffer, OutFragment &outF, InFragment &inF, const glm::uvec2 &pos)
+/**
+ * @brief Default per fragment operations (BlendMode::AUTO).
+ * Fragments with alpha < 1 are blended, depth is written only by fragments with alpha > 0.5.
+ */
+template <DepthFunc F, bool DEPTH_WRITE>
+void perFragmentOperationsAuto(Frame const &framebuffer, OutFragment const &outF, float inDepth, uint64_t idx)
 {
-	glm::vec4 color = glm::clamp(outF.gl_FragColor, glm::vec4(0.f), glm::vec4(1.f));
+	if (!depthCompare<F>(inDepth, framebuffer.depth[idx]))
+		return;
 
-	const uint32_t idx = pos.y * framebuffer.width + pos.x;
+	glm::vec4 color = glm::clamp(outF.gl_FragColor, glm::vec4(0.f), glm::vec4(1.f));
 
 	const float alpha = outF.gl_FragColor.w;
-	const float inDepth = inF.gl_FragCoord.z;
 
-	if ((alpha < 1.0f) && (framebuffer.depth[idx] >= inDepth))
+	if (alpha < 1.0f)
 	{
-		color = glm::mix(
-			glm::vec4(static_cast<float>(framebuffer.color[(4 * idx) + 0] / 255.f),
-					  static_cast<float>(framebuffer.color[(4 * idx) + 1] / 255.f),
-					  static_cast<float>(framebuffer.color[(4 * idx) + 2] / 255.f),
-					  static_cast<float>(framebuffer.color[(4 * idx) + 3] / 255.f)),
-			glm::vec4(color.r, color.g, color.b, color.a), alpha);
+		color = glm::mix(readColor(framebuffer, idx), color, alpha);
 
 		color += glm::vec4(0.0001f);
 
 		color = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f));
 	}
 
-	if (framebuffer.depth[idx] >= inDepth)
-	{
-		if (alpha > 0.5f)
-			framebuffer.depth[idx] = inDepth;
+	if (DEPTH_WRITE && alpha > 0.5f)
+		framebuffer.depth[idx] = inDepth;
 
-		framebuffer.color[(4 * idx) + 0] = static_cast<uint8_t>(color.r * 255.f);
-		framebuffer.color[(4 * idx) + 1] = static_cast<uint8_t>(color.g * 255.f);
-		framebuffer.color[(4 * idx) + 2] = static_cast<uint8_t>(color.b * 255.f);
-		framebuffer.color[(4 * idx) + 3] = static_cast<uint8_t>(color.a * 255.f);
-	}
+	writeColor(framebuffer, idx, color);
 }
 
-void rasterize(Frame const &frame, Triangle const &triangle, Program &prg, ShaderInterface si, bool backFaceCulling)
+/**
+ * @brief Per fragment operations with explicit blend mode.
+ * BlendMode::OFF packs the color and stores it (see opaqueOperations), it does not clamp in float.
+ */
+template <BlendMode B, DepthFunc F, bool DEPTH_WRITE>
+void perFragmentOperations(Frame const &framebuffer, OutFragment const &outF, float inDepth, uint64_t idx)
 {
-	FragmentShader fs = prg.fragmentShader;
-	AttributeType *vs2fs = prg.vs2fs;
-	OutVertex v[3] = {triangle.points[0], triangle.points[1], triangle.points[2]};
+	if (B == BlendMode::OFF)
+		return opaqueOperations<F, DEPTH_WRITE>(framebuffer, packColor(outF.gl_FragColor), inDepth, idx);
+
+	if (!depthCompare<F>(inDepth, framebuffer.depth[idx]))
+		return;
+
+	if (DEPTH_WRITE)
+		framebuffer.depth[idx] = inDepth;
+
+	glm::vec4 color = glm::clamp(outF.gl_FragColor, glm::vec4(0.f), glm::vec4(1.f));
+	if (B == BlendMode::ALPHA)
+		color = glm::mix(readColor(framebuffer, idx), color, color.a);
+	if (B == BlendMode::ADDITIVE)
+		color = glm::min(readColor(framebuffer, idx) + color * color.a, glm::vec4(1.f));
+
+	writeColor(framebuffer, idx, color);
+}
 
-	if (!backFaceCulling)
+/**
+ * @brief Per fragment operations of depth-only draw - color is not touched.
+ */
+template <DepthFunc F, bool DEPTH_WRITE>
+void perFragmentOperationsDepthOnly(Frame const &framebuffer, OutFragment const &, float inDepth, uint64_t idx)
+{
+	if (DEPTH_WRITE && depthCompare<F>(inDepth, framebuffer.depth[idx]))
+		framebuffer.depth[idx] = inDepth;
+}
+
+template <DepthFunc F, bool DEPTH_WRITE>
+FragmentOperations selectPerFragmentOperations(BlendMode blend, bool colorWrite)
+{
+	if (!colorWrite)
+		return {perFragmentOperationsDepthOnly<F, DEPTH_WRITE>};
+	switch (blend)
 	{
-		const float backface = (v[1].gl_Position.x - v[0].gl_Position.x) * (v[2].gl_Position.y - v[0].gl_Position.y) -
-							   (v[2].gl_Position.x - v[0].gl_Position.x) * (v[1].gl_Position.y - v[0].gl_Position.y);
-		if (backface < 0.0f)
-			std::swap(v[1], v[2]);
+	case BlendMode::OFF:
+		return {perFragmentOperations<BlendMode::OFF, F, DEPTH_WRITE>, opaqueOperations<F, DEPTH_WRITE>};
+	case BlendMode::ALPHA:
+		return {perFragmentOperations<BlendMode::ALPHA, F, DEPTH_WRITE>};
+	case BlendMode::ADDITIVE:
+		return {perFragmentOperations<BlendMode::ADDITIVE, F, DEPTH_WRITE>};
+	default:
+		return {perFragmentOperationsAuto<F, DEPTH_WRITE>};
 	}
+}
 
-	glm::vec2 max, min;
-	max.x = max.y = 0.f;
-	min.x = frame.width;
-	min.y = frame.height;
+template <DepthFunc F>
+FragmentOperations selectPerFragmentOperations(BlendMode blend, bool depthWrite, bool colorWrite)
+{
+	if (depthWrite)
+		return selectPerFragmentOperations<F, true>(blend, colorWrite);
+	return selectPerFragmentOperations<F, false>(blend, colorWrite);
+}
 
-	for (int i = 0; i < 3; i++)
+/**
+ * @brief This function selects specialized per fragment operations for the state of draw command.
+ * Disabled depth test also disables depth writes.
+ *
+ * @param cmd draw command
+ * @param colorWrite does the draw write color (false for depth-only draws)
+ *
+ * @return per fragment operations
+ */
+FragmentOperations selectPerFragmentOperations(DrawCommand const &cmd, bool colorWrite)
+{
+	if (!cmd.depthTest)
+		return selectPerFragmentOperations<DepthFunc::ALWAYS, false>(cmd.blend, colorWrite);
+
+	switch (cmd.depthFunc)
 	{
-		max.x = glm::max(max.x, v[i].gl_Position.x);
-		max.y = glm::max(max.y, v[i].gl_Position.y);
-		min.x = glm::min(min.x, v[i].gl_Position.x);
-		min.y = glm::min(min.y, v[i].gl_Position.y);
+	case DepthFunc::NEVER:
+		return selectPerFragmentOperations<DepthFunc::NEVER>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::LESS:
+		return selectPerFragmentOperations<DepthFunc::LESS>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::EQUAL:
+		return selectPerFragmentOperations<DepthFunc::EQUAL>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::GREATER:
+		return selectPerFragmentOperations<DepthFunc::GREATER>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::GEQUAL:
+		return selectPerFragmentOperations<DepthFunc::GEQUAL>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::NOTEQUAL:
+		return selectPerFragmentOperations<DepthFunc::NOTEQUAL>(cmd.blend, cmd.depthWrite, colorWrite);
+	case DepthFunc::ALWAYS:
+		return selectPerFragmentOperations<DepthFunc::ALWAYS>(cmd.blend, cmd.depthWrite, colorWrite);
+	default:
+		return selectPerFragmentOperations<DepthFunc::LEQUAL>(cmd.blend, cmd.depthWrite, colorWrite);
 	}
+}
+
+/**
+ * @brief Fragments of one row of up to 8 pixels that starts at x divisible by 8 (single sampled frame).
+ * The row is one row of a tile of tiled frame, its samples are contiguous in both frame layouts.
+ */
+struct FragmentGroup
+{
+	uint64_t idx = 0;       ///< index of the first sample of the row
+	uint32_t mask = 0;      ///< bit i is set if pixel i has fragment
+	float depth[8] = {};    ///< depths of fragments
+	glm::vec4 color[8] = {}; ///< outputs of fragment shader
+};
 
-	max.x = glm::min(max.x, static_cast<float>(frame.width - 0.5f));
-	max.y = glm::min(max.y, static_cast<float>(frame.height - 0.5f));
-	min.x = glm::max(min.x, 0.0f);
-	min.y = glm::max(min.y, 0.0f);
+/**
+ * @brief Per fragment operations of FragmentGroup (8 pixels at once).
+ */
+using PerFragmentOperations8 = void (*)(Frame const &framebuffer, FragmentGroup const &group);
 
-	glm::vec2 delta[3];
-	for (int i = 0; i < 3; i++)
+#ifdef IZG_RESOLVE_SSE2
+template <DepthFunc F>
+inline __m128 depthCompare4(__m128 inDepth, __m128 depth)
+{
+	switch (F)
 	{
-		int j = (i + 1) % 3;
-		delta[i] = v[j].gl_Position - v[i].gl_Position;
+	case DepthFunc::NEVER:
+		return _mm_setzero_ps();
+	case DepthFunc::LESS:
+		return _mm_cmplt_ps(inDepth, depth);
+	case DepthFunc::LEQUAL:
+		return _mm_cmple_ps(inDepth, depth);
+	case DepthFunc::EQUAL:
+		return _mm_cmpeq_ps(inDepth, depth);
+	case DepthFunc::GREATER:
+		return _mm_cmpgt_ps(inDepth, depth);
+	case DepthFunc::GEQUAL:
+		return _mm_cmpge_ps(inDepth, depth);
+	case DepthFunc::NOTEQUAL:
+		return _mm_cmpneq_ps(inDepth, depth);
+	default:
+		return _mm_castsi128_ps(_mm_set1_epi32(-1));
 	}
+}
+
+/**
+ * @brief This function converts color of one pixel to unorm8 (clamped, truncated like writeColor).
+ *
+ * @return 4 x int32
+ */
+inline __m128i colorToUnorm(glm::vec4 const &color)
+{
+	__m128 c = _mm_loadu_ps(&color.x);
+	c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.f));
+	return _mm_cvttps_epi32(_mm_mul_ps(c, _mm_set1_ps(255.f)));
+}
 
-	for (uint32_t y = static_cast<uint32_t>(min.y); y <= static_cast<int>(max.y); ++y)
+/**
+ * @brief Opaque per fragment operations of FragmentGroup.
+ * Every half of the group is 4 depths in one register and 4 RGBA8 colors in 16 bytes,
+ * so coverage and depth test make one lane mask that selects both depths and colors.
+ * BlendMode::AUTO is opaque if no fragment has alpha < 1, the group is processed per fragment otherwise.
+ */
+template <bool AUTO, DepthFunc F, bool DEPTH_WRITE>
+void perFragmentOperations8(Frame const &framebuffer, FragmentGroup const &group)
+{
+	if (AUTO)
 	{
-		for (uint32_t x = static_cast<uint32_t>(min.x); x <= static_cast<int>(max.x); ++x)
+		for (uint32_t i = 0; i < 8; ++i)
 		{
-			float E[3];
-			glm::uvec2 pos{x, y};
-			glm::vec2 pos_f{x + 0.5f, y + 0.5f};
+			if (!(group.mask & (1u << i)) || group.color[i].a >= 1.f)
+				continue;
+			for (uint32_t j = 0; j < 8; ++j)
+				if (group.mask & (1u << j))
+					perFragmentOperationsAuto<F, DEPTH_WRITE>(framebuffer, OutFragment{group.color[j]}, group.depth[j], group.idx + j);
+			return;
+		}
+	}
 
-			for (int i = 0; i < 3; i++)
-				E[i] = (((pos_f.y - v[i].gl_Position.y) * delta[i].x) - ((pos_f.x - v[i].gl_Position.x) * delta[i].y));
+	const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+	for (uint32_t h = 0; h < 2; ++h)
+	{
+		const uint32_t coverage = (group.mask >> (4 * h)) & 0xfu;
+		if (!coverage)
+			continue;
+		float *depth = framebuffer.depth + group.idx + 4 * h;
+		uint8_t *color = framebuffer.color + 4 * (group.idx + 4 * h);
+
+		const __m128 inDepth = _mm_loadu_ps(group.depth + 4 * h);
+		const __m128 oldDepth = _mm_loadu_ps(depth);
+		const __m128i covered = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(coverage)), bits), bits);
+		const __m128i pass = _mm_and_si128(covered, _mm_castps_si128(depthCompare4<F>(inDepth, oldDepth)));
+		if (_mm_movemask_epi8(pass) == 0)
+			continue;
 
-			if (E[0] >= 0.f && E[1] >= 0.f && E[2] >= 0.f)
-			{
-				InFragment inFragment;
+		if (DEPTH_WRITE)
+			_mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(pass), inDepth), _mm_andnot_ps(_mm_castsi128_ps(pass), oldDepth)));
 
-				fragmentAssembly(inFragment, pos_f, triangle, vs2fs);
+		glm::vec4 const *c = group.color + 4 * h;
+		const __m128i rgba = _mm_packus_epi16(_mm_packs_epi32(colorToUnorm(c[0]), colorToUnorm(c[1])), _mm_packs_epi32(colorToUnorm(c[2]), colorToUnorm(c[3])));
+		const __m128i oldColor = _mm_loadu_si128(reinterpret_cast<__m128i const *>(color));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(color), _mm_or_si128(_mm_and_si128(pass, rgba), _mm_andnot_si128(pass, oldColor)));
+	}
+}
 
-				OutFragment outFragment;
+template <DepthFunc F>
+PerFragmentOperations8 selectPerFragmentOperations8(BlendMode blend, bool depthWrite)
+{
+	if (blend == BlendMode::OFF)
+		return depthWrite ? perFragmentOperations8<false, F, true> : perFragmentOperations8<false, F, false>;
+	if (blend == BlendMode::AUTO)
+		return depthWrite ? perFragmentOperations8<true, F, true> : perFragmentOperations8<true, F, false>;
+	return nullptr;
+}
+#endif
 
-				fs(outFragment, inFragment, si);
+/**
+ * @brief This function selects per fragment operations of FragmentGroup for the state of draw command.
+ * Only opaque draws that write color are vectorized (BlendMode::OFF, AUTO), others use per fragment PerFragmentOperations.
+ *
+ * @param cmd draw command
+ * @param colorWrite does the draw write color (false for depth-only draws)
+ *
+ * @return per fragment operations of group or nullptr
+ */
+PerFragmentOperations8 selectPerFragmentOperations8(DrawCommand const &cmd, bool colorWrite)
+{
+#ifdef IZG_RESOLVE_SSE2
+	if (!colorWrite)
+		return nullptr;
+	if (!cmd.depthTest)
+		return selectPerFragmentOperations8<DepthFunc::ALWAYS>(cmd.blend, false);
 
-				perFragmentOperations(frame, outFragment, inFragment, pos);
-			}
-		}
+	switch (cmd.depthFunc)
+	{
+	case DepthFunc::NEVER:
+		return selectPerFragmentOperations8<DepthFunc::NEVER>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::LESS:
+		return selectPerFragmentOperations8<DepthFunc::LESS>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::EQUAL:
+		return selectPerFragmentOperations8<DepthFunc::EQUAL>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::GREATER:
+		return selectPerFragmentOperations8<DepthFunc::GREATER>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::GEQUAL:
+		return selectPerFragmentOperations8<DepthFunc::GEQUAL>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::NOTEQUAL:
+		return selectPerFragmentOperations8<DepthFunc::NOTEQUAL>(cmd.blend, cmd.depthWrite);
+	case DepthFunc::ALWAYS:
+		return selectPerFragmentOperations8<DepthFunc::ALWAYS>(cmd.blend, cmd.depthWrite);
+	default:
+		return selectPerFragmentOperations8<DepthFunc::LEQUAL>(cmd.blend, cmd.depthWrite);
 	}
+#else
+	(void)cmd;
+	(void)colorWrite;
+	return nullptr;
+#endif
 }
 
-void draw(GPUMemory &mem, DrawCommand cmd, uint32_t draw_id)
-{
-	ShaderInterface si;
-	Program prg = mem.programs[cmd.programID];
-	si.textures = mem.textures;
-	si.uniforms = mem.uniforms;
+/**
+ * @brief Sample positions inside of pixel.
+ * 4 samples use the standard rotated grid pattern.
+ */
+static const glm::vec2 samplePositions1[1] = {{0.5f, 0.5f}};
+static const glm::vec2 samplePositions4[4] = {{0.375f, 0.125f}, {0.875f, 0.375f}, {0.125f, 0.625f}, {0.625f, 0.875f}};
 
-	for (uint32_t n = 0; n < cmd.nofVertices / 3; ++n)
-	{
+/**
+ * @brief Visibility buffer of opaque draws (SubmitFlags::VISIBILITY_BUFFER).
+ * Pass one rasterizes depth into the frame and id of the nearest triangle into ids,
+ * pass two (shadeVisibilityBuffer) executes fragment shader once per covered pixel.
+ */
+struct VisibilityDraw
+{
+	Program prg;                             ///< program of the draw
+	FragmentOperations ops;                  ///< per fragment operations without depth test (depth was resolved by pass one)
+	Uniform drawConstants[maxDrawConstants]; ///< output of prologue
+	bool hasDrawConstants = false;           ///< does the program have prologue
+	uint32_t nofPlanes = 0;                  ///< number of plane equations of every triangle of the draw
+	uint32_t firstPlane[maxAttributes];      ///< first plane of attribute (see TrianglePlanes)
+	bool hasFlat = false;                    ///< does the program have integer attributes (they are stored per triangle)
+};
 
-		Triangle triangle;
+/**
+ * @brief Triangle of visibility buffer, its plane equations and flat attributes are stored in VisibilityBuffer
+ * (only planes that the draw uses, flat attributes only if the draw has integer attributes).
+ */
+struct VisibilityTriangle
+{
+	glm::vec2 origin;        ///< screen position of the first vertex
+	uint32_t firstPlane = 0; ///< index into VisibilityBuffer::planes
+	uint32_t firstFlat = 0;  ///< index into VisibilityBuffer::flat (if VisibilityDraw::hasFlat)
+	uint32_t draw = 0;       ///< index into VisibilityBuffer::draws
+};
 
-		TriangleAssembly(mem, triangle, prg, cmd.vao, si, n, draw_id);
+struct VisibilityBuffer
+{
+	std::vector<uint32_t> ids;                   ///< triangle index + 1 of every sample (0 = empty), see visibilityIndex
+	std::vector<VisibilityTriangle> triangles;   ///< triangles that won at least one sample
+	std::vector<glm::vec3> planes;               ///< plane equations of stored triangles
+	std::vector<Attribute> flat;                 ///< attributes of the first vertex of stored triangles
+	std::vector<VisibilityDraw> draws;           ///< draws of stored triangles
+	bool (*depthTest)(float, float) = nullptr;   ///< depth test of the current draw
+};
 
-		perspectiveDivision(triangle);
+/**
+ * @brief This function returns index of the first sample of pixel in VisibilityBuffer::ids.
+ * Unlike sampleIndex, tiles of tiled frame are not interleaved with color.
+ */
+inline uint64_t visibilityIndex(Frame const &frame, uint32_t x, uint32_t y)
+{
+	if (!frame.tiled)
+		return (static_cast<uint64_t>(y) * frame.width + x) * frame.samples;
+	const uint64_t tilesX = (frame.width + frameTileSize - 1) / frameTileSize;
+	const uint64_t tile = (y / frameTileSize) * tilesX + x / frameTileSize;
+	const uint64_t pixel = (y % frameTileSize) * frameTileSize + x % frameTileSize;
+	return (tile * frameTileSize * frameTileSize + pixel) * frame.samples;
+}
 
-		viewportTransformation(triangle, mem.framebuffer.width, mem.framebuffer.height);
+float const spanMinArea = 128.f; ///< triangles with larger area (in pixels) are rasterized by spans
 
-		rasterize(mem.framebuffer, triangle, prg, si, cmd.backfaceCulling);
-	}
+/**
+ * @brief This function evaluates edge function of edge starting at vertex p (it is >= 0 inside of counter-clockwise triangle).
+ */
+inline float edgeFunction(glm::vec4 const &p, glm::vec2 const &delta, glm::vec2 const &sample)
+{
+	return ((sample.y - p.y) * delta.x) - ((sample.x - p.x) * delta.y);
 }
 
-//! [gpu_execute]
-void gpu_execute(GPUMemory &mem, CommandBuffer &cb)
+/**
+ * @brief This function computes span of row - pixels whose centers are inside of triangle.
+ * Bounds of the span are solved from edge functions, then they are corrected by exact edge tests,
+ * so the span contains the same pixels as per pixel edge tests.
+ *
+ * @param v vertices of counter-clockwise triangle in screen space
+ * @param delta edges of the triangle
+ * @param y row
+ * @param xMin first pixel of bounding box
+ * @param xMax last pixel of bounding box
+ * @param x0 output - first pixel of span
+ * @param x1 output - last pixel of span
+ *
+ * @return false if the span is empty
+ */
+bool rowSpan(glm::vec4 const *v, glm::vec2 const *delta, int32_t y, int32_t xMin, int32_t xMax, int32_t &x0, int32_t &x1)
 {
-	uint32_t draw_id_gpu = 0;
-	for (uint32_t i = 0; i < cb.nofCommands; ++i)
+	const float py = y + 0.5f;
+	float lo = static_cast<float>(xMin);
+	float hi = static_cast<float>(xMax) + 1.f;
+	for (int i = 0; i < 3; ++i)
 	{
-		CommandType type = cb.commands[i].type;
-		CommandData data = cb.commands[i].data;
+		// edge function is a - (px - v.x) * delta.y
+		const float a = (py - v[i].y) * delta[i].x;
+		if (delta[i].y > 0.f)
+			hi = std::min(hi, v[i].x + a / delta[i].y);
+		else if (delta[i].y < 0.f)
+			lo = std::max(lo, v[i].x + a / delta[i].y);
+		else if (a < 0.f)
+			return false;
+	}
+	if (!(lo <= hi))
+		return false;
+
+	const auto inside = [&](int32_t x) {
+		const glm::vec2 sample{x + 0.5f, py};
+		return edgeFunction(v[0], delta[0], sample) >= 0.f && edgeFunction(v[1], delta[1], sample) >= 0.f &&
+			   edgeFunction(v[2], delta[2], sample) >= 0.f;
+	};
+	x0 = std::max(xMin, static_cast<int32_t>(std::ceil(lo - 0.5f)));
+	x1 = std::min(xMax, static_cast<int32_t>(std::floor(hi - 0.5f)));
+	while (x0 > xMin && inside(x0 - 1))
+		--x0;
+	while (x0 <= x1 && !inside(x0))
+		++x0;
+	while (x1 < xMax && inside(x1 + 1))
+		++x1;
+	while (x1 >= x0 && !inside(x1))
+		--x1;
+	return x0 <= x1;
+}
 
-		if (type == CommandType::CLEAR)
-		{
+/**
+ * @brief This function tests centers of the 2x2 candidate pixels of small triangle together.
+ *
+ * @param v vertices of counter-clockwise triangle in screen space
+ * @param delta edges of the triangle
+ * @param corner the first candidate pixel
+ * @param max maximum of bounding box (candidates beyond it are not covered)
+ *
+ * @return bit (y << 1 | x) is set if candidate pixel corner + (x, y) is covered
+ */
+inline uint32_t smallTriangleCoverage(glm::vec4 const *v, glm::vec2 const *delta, glm::uvec2 corner, glm::vec2 max)
+{
+	uint32_t coverage = 0;
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		const glm::vec2 pixel{corner.x + (c & 1u), corner.y + (c >> 1)};
+		const glm::vec2 sample = pixel + 0.5f;
+		const bool inside = (pixel.x <= max.x) & (pixel.y <= max.y) & (edgeFunction(v[0], delta[0], sample) >= 0.f) &
+							(edgeFunction(v[1], delta[1], sample) >= 0.f) & (edgeFunction(v[2], delta[2], sample) >= 0.f);
+		coverage |= static_cast<uint32_t>(inside) << c;
+	}
+	return coverage;
+}
+
+/**
+ * @brief This function rasterizes triangle.
+ * Depth-only draws (prg has no fragment shader or color write is disabled) skip fragment assembly and fragment shader.
+ * Large single sampled triangles are traversed by spans (rowSpan), others by tests of all pixels of bounding box.
+ * Small single sampled triangles (bounding box of at most 2x2 pixels) test their pixels before plane setup,
+ * so triangles that fall between pixel centers (common in dense meshes) cost only a few edge tests
+ * (draws outside of visibility buffer bin them instead, see SmallTriangleBatch).
+ *
+ * @param frame framebuffer
+ * @param triangle triangle in screen space
+ * @param prg program
+ * @param si shader interface
+ * @param backFaceCulling is culling of backfacing triangles enabled
+ * @param ops per fragment operations
+ * @param pfo8 per fragment operations of 8 pixels (see selectPerFragmentOperations8) or nullptr
+ * @param depthOnly is the draw depth-only
+ * @param vis visibility buffer (pass one of SubmitFlags::VISIBILITY_BUFFER) or nullptr
+ */
+void rasterize(Frame const &frame, Triangle const &triangle, Program &prg, ShaderInterface si, bool backFaceCulling, FragmentOperations const &ops, PerFragmentOperations8 pfo8, bool depthOnly,
+			   VisibilityBuffer *vis)
+{
+	FragmentShader fs = prg.fragmentShader;
+	AttributeType *vs2fs = prg.vs2fs;
+	// only positions are needed, attributes are read from triangle by setupPlanes
+	glm::vec4 v[3] = {triangle.points[0].gl_Position, triangle.points[1].gl_Position, triangle.points[2].gl_Position};
+
+	float triangleArea; // in pixels
+	{
+		PROFILE_STAGE(CLIP_CULL);
+		const float backface = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+							   (v[2].x - v[0].x) * (v[1].y - v[0].y);
+		if (backface == 0.f)
+			return; // degenerate triangle
+		if (backface < 0.0f)
+		{
+			// backfacing triangle would not pass the edge test anyway
+			if (backFaceCulling)
+			{
+				PROFILE_COUNT(CULLED_TRIANGLES, 1);
+				return;
+			}
+			std::swap(v[1], v[2]);
+		}
+		triangleArea = 0.5f * std::abs(backface);
+	}
+
+	glm::vec2 max, min;
+	glm::vec2 delta[3];
+	{
+		PROFILE_STAGE(TRIANGLE_SETUP);
+		max.x = max.y = 0.f;
+		min.x = frame.width;
+		min.y = frame.height;
+
+		for (int i = 0; i < 3; i++)
+		{
+			max.x = glm::max(max.x, v[i].x);
+			max.y = glm::max(max.y, v[i].y);
+			min.x = glm::min(min.x, v[i].x);
+			min.y = glm::min(min.y, v[i].y);
+		}
+
+		max.x = glm::min(max.x, static_cast<float>(frame.width - 0.5f));
+		max.y = glm::min(max.y, static_cast<float>(frame.height - 0.5f));
+		min.x = glm::max(min.x, 0.0f);
+		min.y = glm::max(min.y, 0.0f);
+
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			delta[i] = v[j] - v[i];
+		}
+	}
+
+	// plane equations are the most expensive part of setup, they are computed only when the triangle covers something
+	TrianglePlanes planes;
+	const auto setup = [&]() {
+		PROFILE_STAGE(TRIANGLE_SETUP);
+		return setupPlanes(planes, triangle, depthOnly ? nullptr : vs2fs);
+	};
+
+	const uint32_t samples = frame.samples == 4 ? 4 : 1;
+	const glm::vec2 *samplePos = samples == 4 ? samplePositions4 : samplePositions1;
+
+	bool written = false; // did the triangle win any sample of visibility buffer
+	[[maybe_unused]] uint64_t nofFragments = 0; // counted per triangle, the profiler is not called per fragment
+
+	// single sampled fragments are collected into rows of 8 pixels for pfo8
+	// (the last incomplete row of linear frame is not contiguous with padding, it uses ops)
+	FragmentGroup group;
+	uint32_t groupX = 0, groupY = 0;
+	const uint32_t groupWidth = frame.tiled ? frame.width : frame.width & ~7u;
+	const auto flush = [&]() {
+		if (!group.mask)
+			return;
+		PROFILE_STAGE(PER_FRAGMENT_OPS);
+		pfo8(frame, group);
+		group = FragmentGroup{};
+	};
+
+	// coverage is computed per sample, the fragment shader is executed once per pixel
+	const auto emit = [&](uint32_t x, uint32_t y, uint32_t coverage, float const *sampleDepth) {
+		if (vis)
+		{
+			PROFILE_STAGE(PER_FRAGMENT_OPS);
+			const uint64_t idx = sampleIndex(frame, x, y);
+			const uint64_t vid = visibilityIndex(frame, x, y);
+			const auto id = static_cast<uint32_t>(vis->triangles.size() + 1);
+			for (uint32_t s = 0; s < samples; ++s)
+			{
+				if (!(coverage & (1u << s)))
+					continue;
+				const float depth = samples == 1 ? fragmentDepth(glm::vec2{x + 0.5f, y + 0.5f}, planes) : sampleDepth[s];
+				if (!vis->depthTest(depth, frame.depth[idx + s]))
+					continue;
+				frame.depth[idx + s] = depth;
+				vis->ids[vid + s] = id;
+				written = true;
+			}
+			return;
+		}
+
+		if (depthOnly)
+		{
+			PROFILE_STAGE(PER_FRAGMENT_OPS);
+			const uint64_t idx = sampleIndex(frame, x, y);
+			if (samples == 1)
+			{
+				ops.pfo(frame, OutFragment{}, fragmentDepth(glm::vec2{x + 0.5f, y + 0.5f}, planes), idx);
+				return;
+			}
+			for (uint32_t s = 0; s < samples; ++s)
+				if (coverage & (1u << s))
+					ops.pfo(frame, OutFragment{}, sampleDepth[s], idx + s);
+			return;
+		}
+
+		glm::vec2 pos_f{x + 0.5f, y + 0.5f};
+
+		InFragment inFragment;
+
+		fragmentAssembly(inFragment, pos_f, planes);
+
+		OutFragment outFragment;
+
+		{
+			PROFILE_STAGE(FRAGMENT_SHADER);
+			fs(outFragment, inFragment, si);
+		}
+		nofFragments++;
+
+		if (pfo8 && x < groupWidth)
+		{
+			if (group.mask && ((x & ~7u) != groupX || y != groupY))
+				flush();
+			if (!group.mask)
+			{
+				groupX = x & ~7u;
+				groupY = y;
+				group.idx = sampleIndex(frame, groupX, y);
+			}
+			group.mask |= 1u << (x & 7u);
+			group.depth[x & 7u] = inFragment.gl_FragCoord.z;
+			group.color[x & 7u] = outFragment.gl_FragColor;
+			return;
+		}
+
+		PROFILE_STAGE(PER_FRAGMENT_OPS);
+		const uint64_t idx = sampleIndex(frame, x, y);
+		if (ops.opaque)
+		{
+			const uint32_t color = packColor(outFragment.gl_FragColor);
+			if (samples == 1)
+			{
+				ops.opaque(frame, color, inFragment.gl_FragCoord.z, idx);
+				return;
+			}
+			for (uint32_t s = 0; s < samples; ++s)
+				if (coverage & (1u << s))
+					ops.opaque(frame, color, sampleDepth[s], idx + s);
+			return;
+		}
+		if (samples == 1)
+		{
+			ops.pfo(frame, outFragment, inFragment.gl_FragCoord.z, idx);
+			return;
+		}
+		for (uint32_t s = 0; s < samples; ++s)
+			if (coverage & (1u << s))
+				ops.pfo(frame, outFragment, sampleDepth[s], idx + s);
+	};
+
+	PROFILE_STAGE(RASTERIZATION);
+	const auto xMin = static_cast<uint32_t>(min.x);
+	const auto yMin = static_cast<uint32_t>(min.y);
+	if (samples == 1 && max.x < xMin + 2.f && max.y < yMin + 2.f)
+	{
+		// small triangle - at most 2x2 candidate pixels, covered pixels are found before setup
+		const uint32_t covered = smallTriangleCoverage(v, delta, glm::uvec2(xMin, yMin), max);
+		if (!covered || !setup())
+			return;
+		for (uint32_t c = 0; c < 4; ++c)
+			if (covered & (1u << c))
+				emit(xMin + (c & 1u), yMin + (c >> 1), 1u, nullptr);
+	}
+	else if (!setup())
+		return;
+	else if (samples == 1 && triangleArea >= spanMinArea)
+	{
+		// large triangle - exact span of every row, pixels inside of span are not tested
+		for (int32_t y = static_cast<int32_t>(min.y); y <= static_cast<int32_t>(max.y); ++y)
+		{
+			int32_t x0, x1;
+			if (!rowSpan(v, delta, y, static_cast<int32_t>(min.x), static_cast<int32_t>(max.x), x0, x1))
+				continue;
+			for (int32_t x = x0; x <= x1; ++x)
+				emit(x, y, 1u, nullptr);
+		}
+	}
+	else
+	{
+		for (uint32_t y = static_cast<uint32_t>(min.y); y <= static_cast<int>(max.y); ++y)
+		{
+			for (uint32_t x = static_cast<uint32_t>(min.x); x <= static_cast<int>(max.x); ++x)
+			{
+				uint32_t coverage = 0;
+				float sampleDepth[4];
+				for (uint32_t s = 0; s < samples; ++s)
+				{
+					float E[3];
+					const glm::vec2 sample_f{x + samplePos[s].x, y + samplePos[s].y};
+
+					for (int i = 0; i < 3; i++)
+						E[i] = edgeFunction(v[i], delta[i], sample_f);
+
+					if (E[0] >= 0.f && E[1] >= 0.f && E[2] >= 0.f)
+					{
+						coverage |= 1u << s;
+						// edge function of an edge is proportional to the barycentric coordinate of the opposite vertex
+						const float area = E[0] + E[1] + E[2];
+						sampleDepth[s] = (E[1] * v[0].z + E[2] * v[1].z + E[0] * v[2].z) / area;
+					}
+				}
+
+				if (coverage)
+					emit(x, y, coverage, sampleDepth);
+			}
+		}
+	}
+
+	if (pfo8)
+		flush();
+	PROFILE_COUNT(FRAGMENTS, nofFragments);
+
+	if (written)
+	{
+		auto const &d = vis->draws.back();
+		vis->triangles.emplace_back();
+		auto &t = vis->triangles.back();
+		t.origin = planes.origin;
+		t.firstPlane = static_cast<uint32_t>(vis->planes.size());
+		t.draw = static_cast<uint32_t>(vis->draws.size() - 1);
+		vis->planes.insert(vis->planes.end(), planes.planes, planes.planes + d.nofPlanes);
+		if (d.hasFlat)
+		{
+			t.firstFlat = static_cast<uint32_t>(vis->flat.size());
+			vis->flat.insert(vis->flat.end(), triangle.points[0].attributes, triangle.points[0].attributes + maxAttributes);
+		}
+	}
+}
+
+/**
+ * @brief Small triangles of one draw waiting for rasterization (single sampled frame, no visibility buffer).
+ * Triangles are binned in draw order together with coverage of their candidate pixels,
+ * triangles that cover no pixel center are dropped before any setup.
+ * Binned triangles are set up and shaded in one pass by rasterizeSmallTriangles.
+ */
+struct SmallTriangleBatch
+{
+	static constexpr uint32_t capacity = 64;
+	Triangle triangles[capacity];  ///< triangles in screen space
+	glm::uvec2 corners[capacity];  ///< the first candidate pixel of triangle
+	uint32_t coverage[capacity];   ///< covered candidate pixels (see smallTriangleCoverage)
+	uint32_t count = 0;            ///< number of binned triangles
+};
+
+/**
+ * @brief This function bins triangle whose bounding box has at most 2x2 pixels.
+ * The tests are the same as in rasterize, culled and uncovered triangles are only dropped.
+ *
+ * @param batch batch of small triangles
+ * @param frame framebuffer
+ * @param triangle triangle in screen space
+ * @param backFaceCulling is culling of backfacing triangles enabled
+ *
+ * @return false if the triangle is not small (it has to be rasterized after the batch)
+ */
+bool binSmallTriangle(SmallTriangleBatch &batch, Frame const &frame, Triangle const &triangle, bool backFaceCulling)
+{
+	glm::vec4 v[3] = {triangle.points[0].gl_Position, triangle.points[1].gl_Position, triangle.points[2].gl_Position};
+	const glm::vec2 max = glm::min(glm::max(glm::max(glm::vec2(v[0]), glm::vec2(v[1])), glm::vec2(v[2])),
+								   glm::vec2(frame.width - 0.5f, frame.height - 0.5f));
+	const glm::vec2 min = glm::max(glm::min(glm::min(glm::vec2(v[0]), glm::vec2(v[1])), glm::vec2(v[2])), glm::vec2(0.f));
+	const glm::uvec2 corner(min);
+	if (max.x >= corner.x + 2.f || max.y >= corner.y + 2.f)
+		return false;
+
+	PROFILE_STAGE(CLIP_CULL);
+	const float backface = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+	if (backface == 0.f)
+		return true;
+	if (backface < 0.f)
+	{
+		if (backFaceCulling)
+		{
+			PROFILE_COUNT(CULLED_TRIANGLES, 1);
+			return true;
+		}
+		std::swap(v[1], v[2]);
+	}
+
+	const glm::vec2 delta[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+	const uint32_t coverage = smallTriangleCoverage(v, delta, corner, max);
+	if (!coverage)
+		return true;
+
+	batch.triangles[batch.count] = triangle;
+	batch.corners[batch.count] = corner;
+	batch.coverage[batch.count] = coverage;
+	batch.count++;
+	return true;
+}
+
+/**
+ * @brief This function rasterizes binned small triangles in draw order and empties the batch.
+ * Every covered pixel is one fragment, so fragments are shaded in one loop without per triangle traversal state.
+ *
+ * @param frame framebuffer
+ * @param batch batch of small triangles
+ * @param prg program
+ * @param si shader interface
+ * @param ops per fragment operations
+ * @param depthOnly is the draw depth-only
+ */
+void rasterizeSmallTriangles(Frame const &frame, SmallTriangleBatch &batch, Program const &prg, ShaderInterface const &si, FragmentOperations const &ops,
+							 bool depthOnly)
+{
+	if (!batch.count)
+		return;
+	PROFILE_STAGE(RASTERIZATION);
+	[[maybe_unused]] uint64_t nofFragments = 0;
+	TrianglePlanes planes;
+	for (uint32_t t = 0; t < batch.count; ++t)
+	{
+		{
+			PROFILE_STAGE(TRIANGLE_SETUP);
+			if (!setupPlanes(planes, batch.triangles[t], depthOnly ? nullptr : prg.vs2fs))
+				continue;
+		}
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			if (!(batch.coverage[t] & (1u << c)))
+				continue;
+			const uint32_t x = batch.corners[t].x + (c & 1u);
+			const uint32_t y = batch.corners[t].y + (c >> 1);
+			const glm::vec2 pos{x + 0.5f, y + 0.5f};
+			const uint64_t idx = sampleIndex(frame, x, y);
+			if (depthOnly)
+			{
+				ops.pfo(frame, OutFragment{}, fragmentDepth(pos, planes), idx);
+				continue;
+			}
+
+			InFragment inFragment;
+			fragmentAssembly(inFragment, pos, planes);
+			OutFragment outFragment;
+			{
+				PROFILE_STAGE(FRAGMENT_SHADER);
+				prg.fragmentShader(outFragment, inFragment, si);
+			}
+			nofFragments++;
+
+			if (ops.opaque)
+				ops.opaque(frame, packColor(outFragment.gl_FragColor), inFragment.gl_FragCoord.z, idx);
+			else
+				ops.pfo(frame, outFragment, inFragment.gl_FragCoord.z, idx);
+		}
+	}
+	PROFILE_COUNT(FRAGMENTS, nofFragments);
+	batch.count = 0;
+}
+
+/**
+ * @brief This function returns depth test function of depth comparison.
+ */
+bool (*selectDepthTest(DepthFunc func))(float, float)
+{
+	switch (func)
+	{
+	case DepthFunc::NEVER:
+		return depthCompare<DepthFunc::NEVER>;
+	case DepthFunc::LESS:
+		return depthCompare<DepthFunc::LESS>;
+	case DepthFunc::EQUAL:
+		return depthCompare<DepthFunc::EQUAL>;
+	case DepthFunc::GREATER:
+		return depthCompare<DepthFunc::GREATER>;
+	case DepthFunc::GEQUAL:
+		return depthCompare<DepthFunc::GEQUAL>;
+	case DepthFunc::NOTEQUAL:
+		return depthCompare<DepthFunc::NOTEQUAL>;
+	case DepthFunc::ALWAYS:
+		return depthCompare<DepthFunc::ALWAYS>;
+	default:
+		return depthCompare<DepthFunc::LEQUAL>;
+	}
+}
+
+/**
+ * @brief This function decides if draw can be deferred into visibility buffer.
+ * Only opaque draws (BlendMode::OFF) that test and write depth qualify,
+ * BlendMode::AUTO blends fragments with alpha < 1, so it has to see the frame in draw order.
+ *
+ * @param mem gpu memory
+ * @param cmd draw command
+ *
+ * @return true if the draw can be deferred
+ */
+bool isVisibilityDraw(GPUMemory const &mem, DrawCommand const &cmd)
+{
+	auto const &prg = mem.programs[cmd.programID];
+	return prg.fragmentShader && cmd.colorWrite && cmd.depthTest && cmd.depthWrite && cmd.blend == BlendMode::OFF;
+}
+
+void draw(GPUMemory &mem, DrawCommand cmd, uint32_t draw_id, VisibilityBuffer *vis)
+{
+	ShaderInterface si;
+	Program prg = mem.programs[cmd.programID];
+	si.textures = mem.textures;
+	si.uniforms = mem.uniforms;
+
+	Uniform drawConstants[maxDrawConstants];
+	if (prg.prologue)
+	{
+		PROFILE_STAGE(VERTEX_SHADER);
+		prg.prologue(drawConstants, si, draw_id);
+		si.drawConstants = drawConstants;
+	}
+	const bool depthOnly = !cmd.colorWrite || !prg.fragmentShader;
+	const FragmentOperations ops = selectPerFragmentOperations(cmd, !depthOnly);
+	const PerFragmentOperations8 pfo8 = mem.framebuffer.samples == 1 ? selectPerFragmentOperations8(cmd, !depthOnly) : nullptr;
+
+	if (vis)
+	{
+		vis->draws.emplace_back();
+		auto &d = vis->draws.back();
+		d.prg = prg;
+		d.ops = selectPerFragmentOperations<DepthFunc::ALWAYS, false>(cmd.blend, true);
+		d.hasDrawConstants = prg.prologue != nullptr;
+		std::copy_n(drawConstants, maxDrawConstants, d.drawConstants);
+		// the same layout as setupPlanes: depth, 1/w, components of float attributes
+		d.nofPlanes = 2;
+		for (uint32_t i = 0; i < maxAttributes; ++i)
+		{
+			d.firstPlane[i] = d.nofPlanes;
+			d.nofPlanes += nofComponents(prg.vs2fs[i]);
+			d.hasFlat |= prg.vs2fs[i] != AttributeType::EMPTY && !nofComponents(prg.vs2fs[i]);
+		}
+		vis->depthTest = selectDepthTest(cmd.depthFunc);
+	}
+
+	// small triangles are binned, the batch is rasterized before any other triangle, so draw order is kept
+	SmallTriangleBatch batch;
+	const bool binning = mem.framebuffer.samples != 4 && !vis;
+	const auto flushBatch = [&]() { rasterizeSmallTriangles(mem.framebuffer, batch, prg, si, ops, depthOnly); };
+
+	const auto processTriangle = [&](Triangle &triangle) {
+		PROFILE_COUNT(TRIANGLES, 1);
+		{
+			PROFILE_STAGE(TRIANGLE_SETUP);
+			perspectiveDivision(triangle);
+
+			viewportTransformation(triangle, mem.framebuffer.width, mem.framebuffer.height);
+		}
+
+		if (binning)
+		{
+			if (binSmallTriangle(batch, mem.framebuffer, triangle, cmd.backfaceCulling))
+			{
+				if (batch.count == SmallTriangleBatch::capacity)
+					flushBatch();
+				return;
+			}
+			flushBatch();
+		}
+		rasterize(mem.framebuffer, triangle, prg, si, cmd.backfaceCulling, ops, pfo8, depthOnly, vis);
+	};
+
+	const bool restart = cmd.primitiveRestart && cmd.vao.indexBufferID >= 0;
+	if (cmd.topology == Topology::TRIANGLES && !restart)
+	{
+		for (uint32_t n = 0; n < cmd.nofVertices / 3; ++n)
+		{
+
+			Triangle triangle;
+
+			TriangleAssembly(mem, triangle, prg, cmd.vao, si, n, draw_id);
+			PROFILE_COUNT(VERTICES, 3);
+
+			processTriangle(triangle);
+		}
+		flushBatch();
+		return;
+	}
+
+	// every vertex is shaded once, triangles of strips and fans reuse 2 shaded vertices
+	// TRIANGLES: vertices of current triangle, TRIANGLE_STRIP: 2 previous vertices in the order of the next triangle,
+	// TRIANGLE_FAN: the first and the previous vertex
+	const uint32_t restartId = restartIndex(cmd.vao.indexType);
+	OutVertex shaded[3];
+	uint32_t k = 0; // number of vertices since the start or the last restart
+	for (uint32_t i = 0; i < cmd.nofVertices; ++i)
+	{
+		InVertex inVertex;
+		{
+			PROFILE_STAGE(VERTEX_PULL);
+			inVertex.gl_DrawID = draw_id;
+			computeVertexID(mem, cmd.vao, &i, inVertex);
+			if (restart && inVertex.gl_VertexID == restartId)
+			{
+				k = 0;
+				continue;
+			}
+			getAttr(mem, cmd.vao.vertexAttrib, inVertex);
+		}
+
+		OutVertex outVertex;
+		{
+			PROFILE_STAGE(VERTEX_SHADER);
+			prg.vertexShader(outVertex, inVertex, si);
+		}
+		PROFILE_COUNT(VERTICES, 1);
+
+		switch (cmd.topology)
+		{
+		case Topology::TRIANGLE_STRIP:
+			if (k >= 2)
+			{
+				Triangle triangle = {{shaded[0], shaded[1], outVertex}};
+				processTriangle(triangle);
+			}
+			// odd triangles swap the first two vertices, so the oldest vertex is always replaced
+			shaded[k & 1] = outVertex;
+			break;
+
+		case Topology::TRIANGLE_FAN:
+			if (k >= 2)
+			{
+				Triangle triangle = {{shaded[0], shaded[1], outVertex}};
+				processTriangle(triangle);
+			}
+			shaded[std::min(k, 1u)] = outVertex;
+			break;
+
+		default:
+			shaded[k % 3] = outVertex;
+			if (k % 3 == 2)
+			{
+				Triangle triangle = {{shaded[0], shaded[1], shaded[2]}};
+				processTriangle(triangle);
+			}
+			break;
+		}
+		k++;
+	}
+	flushBatch();
+}
+
+/**
+ * @brief This function shades rows [y0,y1) of visibility buffer and clears their ids.
+ * Fragment shader is executed once per pixel and triangle (samples of a pixel can belong to several triangles).
+ */
+void shadeVisibilityRows(GPUMemory const &mem, VisibilityBuffer &vis, uint32_t y0, uint32_t y1)
+{
+	const Frame &frame = mem.framebuffer;
+	const uint32_t samples = frame.samples == 4 ? 4 : 1;
+	ShaderInterface si;
+	si.textures = mem.textures;
+	si.uniforms = mem.uniforms;
+
+	// planes of the last shaded triangle, neighbouring pixels usually belong to the same triangle
+	TrianglePlanes planes;
+	uint32_t current = 0;
+	[[maybe_unused]] uint64_t nofFragments = 0;
+	for (uint32_t y = y0; y < y1; ++y)
+		for (uint32_t x = 0; x < frame.width; ++x)
+		{
+			const uint64_t idx = sampleIndex(frame, x, y);
+			const uint64_t vid = visibilityIndex(frame, x, y);
+			uint32_t done = 0; // samples that were already shaded
+			for (uint32_t s = 0; s < samples; ++s)
+			{
+				const uint32_t id = vis.ids[vid + s];
+				if (!id || (done & (1u << s)))
+					continue;
+
+				auto const &t = vis.triangles[id - 1];
+				auto const &d = vis.draws[t.draw];
+				if (id != current)
+				{
+					current = id;
+					planes.origin = t.origin;
+					planes.nofPlanes = d.nofPlanes;
+					std::copy_n(vis.planes.data() + t.firstPlane, d.nofPlanes, planes.planes);
+					std::copy_n(d.firstPlane, maxAttributes, planes.firstPlane);
+					planes.flat = d.hasFlat ? vis.flat.data() + t.firstFlat : nullptr;
+					planes.vs2fs = d.prg.vs2fs;
+				}
+				si.drawConstants = d.hasDrawConstants ? d.drawConstants : nullptr;
+
+				InFragment inFragment;
+				fragmentAssembly(inFragment, glm::vec2{x + 0.5f, y + 0.5f}, planes);
+				OutFragment outFragment;
+				{
+					PROFILE_STAGE(FRAGMENT_SHADER);
+					d.prg.fragmentShader(outFragment, inFragment, si);
+				}
+				nofFragments++;
+
+				PROFILE_STAGE(PER_FRAGMENT_OPS);
+				const uint32_t color = d.ops.opaque ? packColor(outFragment.gl_FragColor) : 0u;
+				for (uint32_t o = s; o < samples; ++o)
+					if (vis.ids[vid + o] == id)
+					{
+						if (d.ops.opaque)
+							d.ops.opaque(frame, color, frame.depth[idx + o], idx + o);
+						else
+							d.ops.pfo(frame, outFragment, frame.depth[idx + o], idx + o);
+						done |= 1u << o;
+						vis.ids[vid + o] = 0;
+					}
+			}
+		}
+	PROFILE_COUNT(FRAGMENTS, nofFragments);
+}
+
+/**
+ * @brief This function executes pass two of visibility buffer and empties it.
+ *
+ * @param mem gpu memory
+ * @param vis visibility buffer
+ * @param parallel shade bands of tiles by all cores
+ */
+void shadeVisibilityBuffer(GPUMemory const &mem, VisibilityBuffer &vis, bool parallel)
+{
+	if (vis.triangles.empty())
+	{
+		vis.draws.clear();
+		return;
+	}
+
+	const uint32_t height = mem.framebuffer.height;
+	const uint32_t nofThreads = parallel ? std::max(1u, std::thread::hardware_concurrency()) : 1u;
+	if (nofThreads == 1)
+		shadeVisibilityRows(mem, vis, 0, height);
+	else
+	{
+		// bands are one tile high, so threads do not share tiles of tiled frame
+		std::atomic<uint32_t> nextBand{0};
+		const uint32_t nofBands = (height + frameTileSize - 1) / frameTileSize;
+		// every worker records into its own profiler, they are added to the command after join
+		PROFILE_WORKERS(nofThreads);
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < nofThreads; ++t)
+			threads.emplace_back([&, t]() {
+				PROFILE_WORKER(t);
+				for (uint32_t b = nextBand++; b < nofBands; b = nextBand++)
+					shadeVisibilityRows(mem, vis, b * frameTileSize, std::min(height, (b + 1) * frameTileSize));
+			});
+		for (auto &t : threads)
+			t.join();
+	}
+	vis.triangles.clear();
+	vis.planes.clear();
+	vis.flat.clear();
+	vis.draws.clear();
+}
+
+/**
+ * @brief This function decides if draw can be reordered (SubmitFlags::SORT_DRAWS).
+ * Only opaque draws (BlendMode::OFF) that test and write depth can be reordered,
+ * draws that blend (BlendMode::AUTO, ALPHA, ADDITIVE) depend on order.
+ */
+bool isSortableDraw(Command const &cmd)
+{
+	if (cmd.type != CommandType::DRAW)
+		return false;
+	auto const &d = cmd.data.drawCommand;
+	return d.depthTest && d.depthWrite && d.depthFunc != DepthFunc::EQUAL && d.blend == BlendMode::OFF;
+}
+
+/**
+ * @brief This function sorts every run of consecutive sortable draws (between clears and order dependent draws).
+ * Draws are sorted by program and state (DrawCommand::sortState) to reuse caches and front-to-back
+ * by DrawCommand::sortDepth inside of the same state to reject more fragments by depth test.
+ *
+ * @param cb command buffer
+ * @param order output - execution order of commands
+ */
+void sortDraws(CommandBuffer const &cb, std::vector<uint32_t> &order)
+{
+	const auto less = [&](uint32_t a, uint32_t b) {
+		auto const &da = cb.commands[a].data.drawCommand;
+		auto const &db = cb.commands[b].data.drawCommand;
+		if (da.programID != db.programID)
+			return da.programID < db.programID;
+		if (da.sortState != db.sortState)
+			return da.sortState < db.sortState;
+		return da.sortDepth < db.sortDepth;
+	};
+	for (uint32_t begin = 0; begin < cb.nofCommands;)
+	{
+		if (!isSortableDraw(cb.commands[begin]))
+		{
+			begin++;
+			continue;
+		}
+		uint32_t end = begin + 1;
+		while (end < cb.nofCommands && isSortableDraw(cb.commands[end]))
+			end++;
+		std::stable_sort(order.begin() + begin, order.begin() + end, less);
+		begin = end;
+	}
+}
+
+static thread_local SubmitHook submitHook;
+
+void gpu_setSubmitHook(SubmitHook const &hook)
+{
+	submitHook = hook;
+}
+
+//! [gpu_execute]
+void gpu_execute(GPUMemory &mem, CommandBuffer &cb, SubmitFlags flags)
+{
+	if (submitHook)
+		submitHook(mem, cb, flags);
+
+	// visibility buffer is reused by submits of the same thread
+	static thread_local VisibilityBuffer visibilityBuffer;
+	VisibilityBuffer *vis = nullptr;
+	if (hasFlag(flags, SubmitFlags::VISIBILITY_BUFFER))
+	{
+		const Frame &frame = mem.framebuffer;
+		// one id per depth sample, tiled frame has padding of incomplete tiles
+		const uint64_t nofSamples = frame.tiled ? gpu_tiledFrameSize(frame.width, frame.height, frame.samples) / (4 + sizeof(float))
+												: static_cast<uint64_t>(frame.width) * frame.height * frame.samples;
+		visibilityBuffer.ids.assign(nofSamples, 0);
+		vis = &visibilityBuffer;
+	}
+	const bool parallel = hasFlag(flags, SubmitFlags::PARALLEL_SHADING);
+
+	// draw ids (gl_DrawID) follow recorded order even if draws are executed in sorted order
+	static thread_local std::vector<uint32_t> order;
+	static thread_local std::vector<uint32_t> drawIds;
+	order.resize(cb.nofCommands);
+	drawIds.resize(cb.nofCommands);
+	uint32_t nofDraws = 0;
+	for (uint32_t i = 0; i < cb.nofCommands; ++i)
+	{
+		order[i] = i;
+		drawIds[i] = nofDraws;
+		if (cb.commands[i].type == CommandType::DRAW)
+			nofDraws++;
+	}
+	if (hasFlag(flags, SubmitFlags::SORT_DRAWS))
+		sortDraws(cb, order);
+
+	PROFILE_SUBMIT();
+	uint32_t clear_id_gpu = 0;
+	for (uint32_t i = 0; i < cb.nofCommands; ++i)
+	{
+		CommandType type = cb.commands[order[i]].type;
+		CommandData data = cb.commands[order[i]].data;
+		const uint32_t draw_id_gpu = drawIds[order[i]];
+
+		if (type == CommandType::CLEAR)
+		{
+			PROFILE_COMMAND(false, clear_id_gpu++);
+			if (vis)
+				shadeVisibilityBuffer(mem, *vis, parallel);
 			clear(mem, data.clearCommand);
 		}
 		if (type == CommandType::DRAW)
 		{
-			draw(mem, data.drawCommand, draw_id_gpu);
-			draw_id_gpu++;
+			PROFILE_COMMAND(true, draw_id_gpu);
+			if (vis && isVisibilityDraw(mem, data.drawCommand))
+				draw(mem, data.drawCommand, draw_id_gpu, vis);
+			else
+			{
+				// other draws see the frame as if all previous draws were executed
+				if (vis)
+					shadeVisibilityBuffer(mem, *vis, parallel);
+				draw(mem, data.drawCommand, draw_id_gpu, nullptr);
+			}
 		}
 	}
+	if (vis)
+		shadeVisibilityBuffer(mem, *vis, parallel);
 }
 //! [gpu_execute]
 
 /**
- * @brief This function reads color from texture.
+ * @brief This function resolves consecutive pixels (all their samples are next to each other).
  *
- * @param texture texture
+ * @param src color of samples
+ * @param dst resolved color
+ * @param nofPixels number of pixels
+ * @param samples number of samples per pixel
+ */
+void resolvePixels(const uint8_t *src, uint8_t *dst, uint64_t nofPixels, uint32_t samples)
+{
+	if (samples <= 1)
+	{
+		std::memcpy(dst, src, nofPixels * 4);
+		return;
+	}
+#ifdef IZG_RESOLVE_SSE2
+	if (samples == 4)
+	{
+		// 4 RGBA8 samples of a pixel are 16 bytes - one register
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(2);
+		for (uint64_t i = 0; i < nofPixels; ++i)
+		{
+			const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 16));
+			__m128i sum = _mm_add_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpackhi_epi8(s, zero));
+			sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+			const int32_t rgba = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+			std::memcpy(dst + i * 4, &rgba, 4);
+		}
+		return;
+	}
+#endif
+	for (uint64_t i = 0; i < nofPixels; ++i)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			uint32_t sum = samples / 2;
+			for (uint32_t s = 0; s < samples; ++s)
+				sum += src[(i * samples + s) * 4 + c];
+			dst[i * 4 + c] = static_cast<uint8_t>(sum / samples);
+		}
+	}
+}
+
+bool isIdentity(PresentTarget const &target)
+{
+	return target.writeAlpha && target.shifts[0] == 0 && target.shifts[1] == 8 && target.shifts[2] == 16 && target.shifts[3] == 24;
+}
+
+/**
+ * @brief This function stores RGBA8 pixels into target pixel format.
+ *
+ * @param src RGBA8 pixels
+ * @param dst pixels in target format
+ * @param nofPixels number of pixels
+ * @param target target format
+ */
+void storePixels(const uint8_t *src, uint8_t *dst, uint64_t nofPixels, PresentTarget const &target)
+{
+	if (isIdentity(target))
+	{
+		std::memcpy(dst, src, nofPixels * 4);
+		return;
+	}
+	uint64_t i = 0;
+#ifdef IZG_RESOLVE_SSE2
+	// 4 pixels at once, every channel is masked and shifted to its position
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i r = _mm_cvtsi32_si128(target.shifts[0]);
+	const __m128i g = _mm_cvtsi32_si128(target.shifts[1]);
+	const __m128i b = _mm_cvtsi32_si128(target.shifts[2]);
+	const __m128i a = _mm_cvtsi32_si128(target.shifts[3]);
+	for (; i + 4 <= nofPixels; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+		__m128i o = _mm_sll_epi32(_mm_and_si128(p, mask), r);
+		o = _mm_or_si128(o, _mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(p, 8), mask), g));
+		o = _mm_or_si128(o, _mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(p, 16), mask), b));
+		if (target.writeAlpha)
+			o = _mm_or_si128(o, _mm_sll_epi32(_mm_srli_epi32(p, 24), a));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), o);
+	}
+#endif
+	for (; i < nofPixels; ++i)
+	{
+		const uint8_t *p = src + i * 4;
+		uint32_t o = (uint32_t(p[0]) << target.shifts[0]) | (uint32_t(p[1]) << target.shifts[1]) | (uint32_t(p[2]) << target.shifts[2]);
+		if (target.writeAlpha)
+			o |= uint32_t(p[3]) << target.shifts[3];
+		std::memcpy(dst + i * 4, &o, 4);
+	}
+}
+
+void gpu_present(Frame const &frame, PresentTarget const &target)
+{
+	// pixels are processed in runs that are consecutive in frame: rows of tiles or parts of rows
+	const uint32_t maxRun = 256;
+	uint8_t resolved[4 * maxRun];
+	const uint32_t runLength = frame.tiled ? frameTileSize : maxRun;
+	const bool identity = isIdentity(target);
+
+	for (uint32_t y = 0; y < frame.height; ++y)
+	{
+		uint8_t *row = target.pixels + (target.flipY ? frame.height - 1 - y : y) * target.pitch;
+		for (uint32_t x = 0; x < frame.width; x += runLength)
+		{
+			const uint32_t n = std::min(runLength, frame.width - x);
+			const uint8_t *src = frame.color + 4 * sampleIndex(frame, x, y);
+			uint8_t *dst = row + 4 * static_cast<uint64_t>(x);
+			if (frame.samples <= 1)
+				storePixels(src, dst, n, target);
+			else if (identity)
+				resolvePixels(src, dst, n, frame.samples);
+			else
+			{
+				resolvePixels(src, resolved, n, frame.samples);
+				storePixels(resolved, dst, n, target);
+			}
+		}
+	}
+}
+
+void gpu_resolve(Frame const &msFrame, Frame &frame)
+{
+	PresentTarget target;
+	target.pixels = frame.color;
+	target.pitch = 4 * static_cast<int64_t>(frame.width);
+	gpu_present(msFrame, target);
+}
+
+/**
+ * @brief This function records mip level used by sampling into feedback of texture (the finest level wins).
+ *
+ * @param texture texture with sampling feedback
+ * @param level mip level of level 0 of the texture
+ */
+inline void recordTextureLevel(Texture const &texture, uint32_t level)
+{
+	// the feedback is mostly only read, so shading threads do not fight for its cache line
+	auto &feedback = *texture.feedback;
+	uint32_t current = feedback.load(std::memory_order_relaxed);
+	while (level < current && !feedback.compare_exchange_weak(current, level, std::memory_order_relaxed))
+		;
+}
+
+/**
+ * @brief This function reads nearest texel of texture.
+ *
+ * @param texture texture with data
  * @param uv uv coordinates
  *
  * @return color 4 floats
  */
-glm::vec4 read_texture(Texture const &texture, glm::vec2 uv)
+inline glm::vec4 readNearest(Texture const &texture, glm::vec2 uv)
 {
-	if (!texture.data)
-		return glm::vec4(0.f);
 	auto uv1 = glm::fract(uv);
 	auto uv2 = uv1 * glm::vec2(texture.width - 1, texture.height - 1) + 0.5f;
 	auto pix = glm::uvec2(uv2);
@@ -409,3 +1957,46 @@ glm::vec4 read_texture(Texture const &texture, glm::vec2 uv)
 		color[c] = texture.data[(pix.y * texture.width + pix.x) * texture.channels + c] / 255.f;
 	return color;
 }
+
+/**
+ * @brief This function reads color from texture.
+ * Texture with sampling feedback (Texture::feedback) is marked as used, its mip level is not known.
+ *
+ * @param texture texture
+ * @param uv uv coordinates
+ *
+ * @return color 4 floats
+ */
+glm::vec4 read_texture(Texture const &texture, glm::vec2 uv)
+{
+	if (!texture.data)
+		return glm::vec4(0.f);
+	if (texture.feedback)
+		recordTextureLevel(texture, unknownTextureLevel);
+	return readNearest(texture, uv);
+}
+
+/**
+ * @brief This function reads color from texture with known footprint of the fragment.
+ * Mip level whose texel covers the footprint (relative to level 0) is recorded into sampling feedback (Texture::feedback),
+ * the resident level is sampled.
+ *
+ * @param texture texture
+ * @param uv uv coordinates
+ * @param duvdx change of uv coordinates between neighbouring pixels in x
+ * @param duvdy change of uv coordinates between neighbouring pixels in y
+ *
+ * @return color 4 floats
+ */
+glm::vec4 read_texture(Texture const &texture, glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy)
+{
+	if (!texture.data)
+		return glm::vec4(0.f);
+	if (texture.feedback)
+	{
+		auto const size = glm::vec2(texture.width << texture.level, texture.height << texture.level);
+		float const footprint = glm::max(glm::length(duvdx * size), glm::length(duvdy * size));
+		recordTextureLevel(texture, footprint > 1.f ? static_cast<uint32_t>(glm::min(std::log2(footprint), 31.f)) : 0u);
+	}
+	return readNearest(texture, uv);
+}
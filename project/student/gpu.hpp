@@ -9,20 +9,113 @@
 #include <student/fwd.hpp>
 #include <stdio.h>
 #include <iostream>
+#include <functional>
 struct Triangle
 {
     OutVertex points[3];
 };
 
+/**
+ * @brief Flags of command buffer submission.
+ */
+enum class SubmitFlags : uint32_t
+{
+    NONE              = 0,      ///< commands are executed one by one
+    VISIBILITY_BUFFER = 1 << 0, ///< opaque draws are rasterized into visibility buffer, fragment shader runs once per visible pixel
+    PARALLEL_SHADING  = 1 << 1, ///< visibility buffer is shaded by all cores (bands of tiles)
+    SORT_DRAWS        = 1 << 2, ///< opaque draws between clears are sorted by program, DrawCommand::sortState and DrawCommand::sortDepth
+};
+
+inline SubmitFlags operator|(SubmitFlags a, SubmitFlags b)
+{
+    return static_cast<SubmitFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+inline bool hasFlag(SubmitFlags flags, SubmitFlags flag)
+{
+    return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(flag)) != 0;
+}
+
 /**
  * @brief function that executes work stored in command buffer on the gpu memory.
  * This function represents the functionality of GPU.
  * It can render stuff, it can clear framebuffer.
  * It can process work stored in command buffer
  *
+ * With SubmitFlags::VISIBILITY_BUFFER consecutive opaque draws (they test and write depth, BlendMode::OFF)
+ * only store depth and id of the nearest triangle, the fragment shader is executed once per covered pixel
+ * before the next clear, non-opaque draw or the end of the command buffer.
+ *
+ * With SubmitFlags::SORT_DRAWS runs of consecutive opaque draws that test and write depth (BlendMode::OFF)
+ * are executed sorted by state and front-to-back, draws that blend keep their position. gl_DrawID of every draw
+ * is its recorded index.
+ *
  * @param mem gpu memory
  * @param cb command buffer - packaged of work sent to the gpu
+ * @param flags submission flags
+ */
+void gpu_execute(GPUMemory &mem, CommandBuffer &cb, SubmitFlags flags = SubmitFlags::NONE);
+
+/**
+ * @brief Function that is called with the gpu memory, command buffer and submission flags before they are executed.
+ */
+using SubmitHook = std::function<void(GPUMemory const &mem, CommandBuffer const &cb, SubmitFlags flags)>;
+
+/**
+ * @brief This function sets submit hook of the calling thread (e.g. frame capture).
+ *
+ * @param hook hook or nullptr
+ */
+void gpu_setSubmitHook(SubmitHook const &hook);
+
+/**
+ * @brief This struct describes 32 bit image that receives presented frame (e.g. window surface).
+ */
+struct PresentTarget
+{
+    uint8_t *pixels = nullptr;              ///< pixels of the first row
+    int64_t pitch = 0;                      ///< bytes per row
+    uint32_t shifts[4] = {0, 8, 16, 24};    ///< bit positions of red, green, blue and alpha in 32 bit pixel
+    bool writeAlpha = true;                 ///< should alpha be written (false = formats without alpha)
+    bool flipY = false;                     ///< the first row of the target is the last row of the frame
+};
+
+/**
+ * @brief This function writes frame (linear, multisampled or tiled) into target in its pixel format.
+ * Samples are resolved, channels are shuffled and rows are flipped in one pass.
+ *
+ * @param frame frame
+ * @param target output image of the same size
+ */
+void gpu_present(Frame const &frame, PresentTarget const &target);
+
+/**
+ * @brief This function resolves multisampled and/or tiled frame into linear single sampled frame (average of samples).
+ * Only color is resolved.
+ *
+ * @param msFrame multisampled and/or tiled frame
+ * @param frame output frame of the same size
+ */
+void gpu_resolve(Frame const &msFrame, Frame &frame);
+
+/**
+ * @brief This function clears frame (linear, multisampled or tiled) without command buffer.
+ *
+ * @param frame frame
+ * @param cmd clear command
+ */
+void gpu_clear(Frame const &frame, ClearCommand const &cmd);
+
+/**
+ * @brief This function returns size of tiled frame storage in bytes (color and depth).
+ *
+ * @param width width of frame
+ * @param height height of frame
+ * @param samples number of samples per pixel
+ *
+ * @return size in bytes
  */
-void gpu_execute(GPUMemory &mem, CommandBuffer &cb);
+uint64_t gpu_tiledFrameSize(uint32_t width, uint32_t height, uint32_t samples);
 
 glm::vec4 read_texture(Texture const &texture, glm::vec2 uv);
+glm::vec4 read_texture(Texture const &texture, glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy);
@@ -0,0 +1,342 @@
+/*!
+ * @file
+ * @brief This file contains implementation of gpu pipeline instrumentation.
+ */
+
+#include <student/profiler.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace profiler
+{
+
+static thread_local Profiler *activeProfiler = nullptr;
+
+char const *stageName(Stage s)
+{
+	switch (s)
+	{
+	case Stage::CLEAR:            return "clear";
+	case Stage::VERTEX_PULL:      return "vertex pull";
+	case Stage::VERTEX_SHADER:    return "vertex shading";
+	case Stage::CLIP_CULL:        return "clipping/culling";
+	case Stage::TRIANGLE_SETUP:   return "triangle setup";
+	case Stage::RASTERIZATION:    return "rasterization";
+	case Stage::FRAGMENT_SHADER:  return "fragment shading";
+	case Stage::PER_FRAGMENT_OPS: return "per-fragment operations";
+	default:                      break;
+	}
+	return "unknown";
+}
+
+char const *counterName(Counter c)
+{
+	switch (c)
+	{
+	case Counter::DRAWS:            return "draws";
+	case Counter::CLEARS:           return "clears";
+	case Counter::VERTICES:         return "vertices";
+	case Counter::TRIANGLES:        return "triangles";
+	case Counter::CULLED_TRIANGLES: return "culled triangles";
+	case Counter::FRAGMENTS:        return "fragments";
+	default:                        break;
+	}
+	return "unknown";
+}
+
+Profiler::Profiler(size_t maxFrames) : epoch(std::chrono::steady_clock::now()), maxFrames(maxFrames)
+{
+}
+
+Profiler *Profiler::active()
+{
+	return activeProfiler;
+}
+
+void Profiler::setActive(Profiler *p)
+{
+	activeProfiler = p;
+}
+
+uint64_t Profiler::now() const
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+bool Profiler::isInFrame() const
+{
+	return inFrame;
+}
+
+void Profiler::beginFrame()
+{
+	if (inFrame)
+		endFrame();
+	if (maxFrames && frames.size() >= maxFrames)
+		frames.pop_front();
+	frames.emplace_back();
+	frames.back().index = frameCounter++;
+	frames.back().start = now();
+	inFrame = true;
+}
+
+void Profiler::endFrame()
+{
+	if (!inFrame)
+		return;
+	if (inCommand)
+		endCommand();
+	frames.back().end = now();
+	inFrame = false;
+}
+
+void Profiler::beginCommand(bool isDraw, uint32_t id)
+{
+	if (!inFrame)
+		beginFrame();
+	auto &frame = frames.back();
+	frame.commands.emplace_back();
+	auto &cmd = frame.commands.back();
+	cmd.isDraw = isDraw;
+	cmd.id = id;
+	cmd.start = now();
+	cmd.counters[static_cast<uint32_t>(isDraw ? Counter::DRAWS : Counter::CLEARS)] = 1;
+	inCommand = true;
+	childNs = 0;
+	childStack.clear();
+}
+
+void Profiler::endCommand()
+{
+	if (!inCommand)
+		return;
+	auto &frame = frames.back();
+	auto &cmd = frame.commands.back();
+	cmd.end = now();
+	for (uint32_t i = 0; i < nofStages; ++i)
+		frame.stageNs[i] += cmd.stageNs[i];
+	for (uint32_t i = 0; i < nofCounters; ++i)
+		frame.counters[i] += cmd.counters[i];
+	inCommand = false;
+}
+
+void Profiler::beginStage()
+{
+	childStack.push_back(childNs);
+	childNs = 0;
+}
+
+void Profiler::endStage(Stage s, uint64_t start)
+{
+	uint64_t const elapsed = now() - start;
+	uint64_t const exclusive = elapsed > childNs ? elapsed - childNs : 0;
+	if (inCommand)
+		frames.back().commands.back().stageNs[static_cast<uint32_t>(s)] += exclusive;
+	else if (inFrame)
+		frames.back().stageNs[static_cast<uint32_t>(s)] += exclusive;
+	childNs = (childStack.empty() ? 0 : childStack.back()) + elapsed;
+	if (!childStack.empty())
+		childStack.pop_back();
+}
+
+void Profiler::count(Counter c, uint64_t n)
+{
+	if (inCommand)
+		frames.back().commands.back().counters[static_cast<uint32_t>(c)] += n;
+	else if (inFrame)
+		frames.back().counters[static_cast<uint32_t>(c)] += n;
+}
+
+/**
+ * @brief This function adds stage times and counters of other profiler (e.g. of worker thread) to the current command.
+ *
+ * @param stats statistics of the other profiler
+ */
+void Profiler::accumulate(FrameStats const &stats)
+{
+	if (!inFrame)
+		return;
+	// command statistics are added to the frame when the command ends
+	uint64_t *stageNs  = inCommand ? frames.back().commands.back().stageNs : frames.back().stageNs;
+	uint64_t *counters = inCommand ? frames.back().commands.back().counters : frames.back().counters;
+	for (uint32_t i = 0; i < nofStages; ++i)
+		stageNs[i] += stats.stageNs[i];
+	for (uint32_t i = 0; i < nofCounters; ++i)
+		counters[i] += stats.counters[i];
+}
+
+std::deque<FrameStats> const &Profiler::getFrames() const
+{
+	return frames;
+}
+
+void Profiler::clear()
+{
+	frames.clear();
+	inFrame = false;
+	inCommand = false;
+	childNs = 0;
+	childStack.clear();
+}
+
+/**
+ * @brief This function returns textual summary of recorded frames.
+ * It contains average per frame stage times, counters and the most expensive draws of the last frame.
+ *
+ * @return summary
+ */
+std::string Profiler::summary() const
+{
+	std::stringstream ss;
+	ss << "gpu profile - " << frames.size() << " frame(s)" << std::endl;
+#ifndef IZG_PROFILING
+	ss << "  instrumentation is disabled at compile time (cmake -DIZG_PROFILING=ON)" << std::endl;
+#endif
+	if (frames.empty())
+		return ss.str();
+
+	double const nofFrames = static_cast<double>(frames.size());
+	uint64_t stageNs[nofStages] = {};
+	uint64_t counters[nofCounters] = {};
+	uint64_t frameNs = 0;
+	for (auto const &f : frames)
+	{
+		frameNs += f.end - f.start;
+		for (uint32_t i = 0; i < nofStages; ++i)
+			stageNs[i] += f.stageNs[i];
+		for (uint32_t i = 0; i < nofCounters; ++i)
+			counters[i] += f.counters[i];
+	}
+
+	uint64_t stagesTotal = 0;
+	for (uint32_t i = 0; i < nofStages; ++i)
+		stagesTotal += stageNs[i];
+
+	ss << std::fixed << std::setprecision(3);
+	ss << "  frame time: " << (frameNs / nofFrames) * 1e-6 << " ms (avg)" << std::endl;
+	ss << "  stage                      ms/frame      share" << std::endl;
+	for (uint32_t i = 0; i < nofStages; ++i)
+	{
+		double const share = stagesTotal ? 100.0 * stageNs[i] / stagesTotal : 0.0;
+		ss << "  " << std::left << std::setw(24) << stageName(static_cast<Stage>(i)) << std::right
+		   << std::setw(12) << (stageNs[i] / nofFrames) * 1e-6
+		   << std::setw(10) << share << " %" << std::endl;
+	}
+	ss << "  counter                   per frame" << std::endl;
+	for (uint32_t i = 0; i < nofCounters; ++i)
+		ss << "  " << std::left << std::setw(24) << counterName(static_cast<Counter>(i)) << std::right
+		   << std::setw(12) << counters[i] / nofFrames << std::endl;
+
+	auto const &last = frames.back();
+	std::vector<CommandStats const *> draws;
+	for (auto const &c : last.commands)
+		if (c.isDraw)
+			draws.push_back(&c);
+	std::sort(draws.begin(), draws.end(), [](CommandStats const *a, CommandStats const *b)
+			  { return (a->end - a->start) > (b->end - b->start); });
+	size_t const nofShown = std::min<size_t>(draws.size(), 10);
+	if (nofShown)
+		ss << "  most expensive draws of the last frame:" << std::endl;
+	for (size_t i = 0; i < nofShown; ++i)
+	{
+		auto const &d = *draws[i];
+		ss << "    draw " << std::setw(5) << d.id << ": " << std::setw(10) << (d.end - d.start) * 1e-6 << " ms"
+		   << "  triangles: " << d.counters[static_cast<uint32_t>(Counter::TRIANGLES)]
+		   << "  fragments: " << d.counters[static_cast<uint32_t>(Counter::FRAGMENTS)] << std::endl;
+	}
+	return ss.str();
+}
+
+static void writeEvent(std::stringstream &ss, bool &first, std::string const &name, char const *cat, uint64_t ts, uint64_t dur, std::string const &args = "")
+{
+	if (!first)
+		ss << "," << std::endl;
+	first = false;
+	ss << "{\"name\":\"" << name << "\",\"cat\":\"" << cat << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+	   << ",\"ts\":" << ts / 1000.0 << ",\"dur\":" << dur / 1000.0;
+	if (!args.empty())
+		ss << ",\"args\":{" << args << "}";
+	ss << "}";
+}
+
+/**
+ * @brief This function returns recorded frames in Chrome trace_event JSON format (chrome://tracing, Perfetto).
+ * Stages are interleaved inside a draw, so they are emitted as consecutive slices
+ * whose durations are the aggregated exclusive times.
+ *
+ * @return json string
+ */
+std::string Profiler::chromeTrace() const
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3);
+	ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+	bool first = true;
+	for (auto const &f : frames)
+	{
+		std::stringstream fargs;
+		for (uint32_t i = 0; i < nofCounters; ++i)
+			fargs << (i ? "," : "") << "\"" << counterName(static_cast<Counter>(i)) << "\":" << f.counters[i];
+		writeEvent(ss, first, "frame " + std::to_string(f.index), "frame", f.start, f.end - f.start, fargs.str());
+		for (auto const &c : f.commands)
+		{
+			std::stringstream cargs;
+			for (uint32_t i = 0; i < nofCounters; ++i)
+				cargs << (i ? "," : "") << "\"" << counterName(static_cast<Counter>(i)) << "\":" << c.counters[i];
+			std::string const name = (c.isDraw ? "draw " : "clear ") + std::to_string(c.id);
+			writeEvent(ss, first, name, c.isDraw ? "draw" : "clear", c.start, c.end - c.start, cargs.str());
+			uint64_t ts = c.start;
+			for (uint32_t i = 0; i < nofStages; ++i)
+			{
+				if (!c.stageNs[i])
+					continue;
+				writeEvent(ss, first, stageName(static_cast<Stage>(i)), "stage", ts, c.stageNs[i], "\"aggregated\":true");
+				ts += c.stageNs[i];
+			}
+		}
+	}
+	ss << std::endl
+	   << "]}" << std::endl;
+	return ss.str();
+}
+
+/**
+ * @brief This function writes Chrome trace_event JSON file.
+ *
+ * @param fileName output file
+ *
+ * @return true if the file was written
+ */
+bool Profiler::writeChromeTrace(std::string const &fileName) const
+{
+	std::ofstream file(fileName);
+	if (!file.is_open())
+		return false;
+	file << chromeTrace();
+	return file.good();
+}
+
+/**
+ * @brief This function prints summary to stdout and/or writes chrome trace.
+ *
+ * @param p profiler
+ * @param printSummary should the summary be printed
+ * @param traceFile chrome trace file or empty string
+ */
+void report(Profiler const &p, bool printSummary, std::string const &traceFile)
+{
+	if (printSummary)
+		std::cout << p.summary();
+	if (traceFile.empty())
+		return;
+	if (p.writeChromeTrace(traceFile))
+		std::cerr << "storing gpu trace to: \"" << traceFile << "\"" << std::endl;
+	else
+		std::cerr << "cannot write gpu trace to: \"" << traceFile << "\"" << std::endl;
+}
+
+} // namespace profiler
@@ -0,0 +1,272 @@
+/*!
+ * @file
+ * @brief This file contains instrumentation of the gpu pipeline (scoped stage timers and counters).
+ *
+ * Instrumentation is compiled in only if IZG_PROFILING is defined (cmake option IZG_PROFILING, off by default,
+ * stage timers of fragment shading and per fragment operations are taken per fragment).
+ * Even when it is compiled in, nothing is recorded until a Profiler is activated on the calling thread.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace profiler
+{
+
+/**
+ * @brief This enum represents instrumented stages of the pipeline.
+ */
+enum class Stage
+{
+	CLEAR = 0,          ///< clearing of framebuffer
+	VERTEX_PULL,        ///< vertex assembly - index and attribute fetch
+	VERTEX_SHADER,      ///< vertex shader invocations
+	CLIP_CULL,          ///< clipping and backface culling
+	TRIANGLE_SETUP,     ///< perspective division, viewport transformation, bounding box, edges
+	RASTERIZATION,      ///< traversal of pixels and fragment assembly
+	FRAGMENT_SHADER,    ///< fragment shader invocations
+	PER_FRAGMENT_OPS,   ///< depth test, blending and writes
+	NOF_STAGES,
+};
+
+/**
+ * @brief This enum represents instrumented counters of the pipeline.
+ */
+enum class Counter
+{
+	DRAWS = 0,          ///< number of draw commands
+	CLEARS,             ///< number of clear commands
+	VERTICES,           ///< number of vertex shader invocations
+	TRIANGLES,          ///< number of assembled triangles
+	CULLED_TRIANGLES,   ///< number of triangles rejected by culling/clipping
+	FRAGMENTS,          ///< number of fragment shader invocations
+	NOF_COUNTERS,
+};
+
+uint32_t const nofStages   = static_cast<uint32_t>(Stage::NOF_STAGES);
+uint32_t const nofCounters = static_cast<uint32_t>(Counter::NOF_COUNTERS);
+
+char const *stageName(Stage s);
+char const *counterName(Counter c);
+
+/**
+ * @brief Aggregated statistics of one command (draw or clear).
+ */
+struct CommandStats
+{
+	bool     isDraw          = false;   ///< draw or clear command
+	uint32_t id              = 0;       ///< gl_DrawID for draws, index of the clear otherwise
+	uint64_t start           = 0;       ///< start time in ns (relative to profiler epoch)
+	uint64_t end             = 0;       ///< end time in ns (relative to profiler epoch)
+	uint64_t stageNs[nofStages]     = {}; ///< exclusive time spent in each stage
+	uint64_t counters[nofCounters]  = {}; ///< counters
+};
+
+/**
+ * @brief Aggregated statistics of one frame.
+ */
+struct FrameStats
+{
+	uint64_t index = 0;                 ///< frame number
+	uint64_t start = 0;                 ///< start time in ns (relative to profiler epoch)
+	uint64_t end   = 0;                 ///< end time in ns (relative to profiler epoch)
+	uint64_t stageNs[nofStages]     = {}; ///< exclusive time spent in each stage (sum over commands)
+	uint64_t counters[nofCounters]  = {}; ///< counters (sum over commands)
+	std::vector<CommandStats> commands; ///< per command statistics
+};
+
+/**
+ * @brief This class collects per draw and per frame statistics of the gpu.
+ * It has to be activated on a thread to record anything (see ActiveProfiler).
+ */
+class Profiler
+{
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param maxFrames maximal number of retained frames (oldest frames are dropped)
+	 */
+	Profiler(size_t maxFrames = 1000);
+	void beginFrame();
+	void endFrame();
+	bool isInFrame() const;
+	void beginCommand(bool isDraw, uint32_t id);
+	void endCommand();
+	void beginStage();
+	void endStage(Stage s, uint64_t start);
+	void count(Counter c, uint64_t n = 1);
+	void accumulate(FrameStats const &stats);
+	uint64_t now() const;
+
+	std::string summary() const;
+	std::string chromeTrace() const;
+	bool writeChromeTrace(std::string const &fileName) const;
+
+	std::deque<FrameStats> const &getFrames() const;
+	void clear();
+
+	static Profiler *active();
+	static void setActive(Profiler *p);
+
+private:
+	std::chrono::steady_clock::time_point epoch;
+	std::deque<FrameStats> frames;
+	size_t   maxFrames      = 1000;
+	uint64_t frameCounter   = 0;
+	bool     inFrame        = false;
+	bool     inCommand      = false;
+	uint64_t childNs        = 0; ///< time of nested stages that has to be subtracted from the parent stage
+	std::vector<uint64_t> childStack;
+};
+
+/**
+ * @brief RAII helper that activates a profiler on the current thread.
+ */
+class ActiveProfiler
+{
+public:
+	ActiveProfiler(Profiler *p) : previous(Profiler::active()) { Profiler::setActive(p); }
+	~ActiveProfiler() { Profiler::setActive(previous); }
+
+private:
+	Profiler *previous;
+};
+
+/**
+ * @brief Scoped timer of one pipeline stage. Time of nested stages is excluded.
+ */
+class ScopedStage
+{
+public:
+	ScopedStage(Stage s) : profiler(Profiler::active()), stage(s)
+	{
+		if (!profiler)
+			return;
+		profiler->beginStage();
+		start = profiler->now();
+	}
+	~ScopedStage()
+	{
+		if (profiler)
+			profiler->endStage(stage, start);
+	}
+
+private:
+	Profiler *profiler;
+	Stage stage;
+	uint64_t start = 0;
+};
+
+/**
+ * @brief Scoped marker of one command buffer submission.
+ * It opens a frame if the caller has not opened one (e.g. tests calling gpu_execute directly).
+ */
+class ScopedSubmit
+{
+public:
+	ScopedSubmit() : profiler(Profiler::active())
+	{
+		if (!profiler || profiler->isInFrame())
+		{
+			profiler = nullptr;
+			return;
+		}
+		profiler->beginFrame();
+	}
+	~ScopedSubmit()
+	{
+		if (profiler)
+			profiler->endFrame();
+	}
+
+private:
+	Profiler *profiler;
+};
+
+/**
+ * @brief Scoped marker of one command.
+ */
+class ScopedCommand
+{
+public:
+	ScopedCommand(bool isDraw, uint32_t id) : profiler(Profiler::active())
+	{
+		if (profiler)
+			profiler->beginCommand(isDraw, id);
+	}
+	~ScopedCommand()
+	{
+		if (profiler)
+			profiler->endCommand();
+	}
+
+private:
+	Profiler *profiler;
+};
+
+/**
+ * @brief Profilers of worker threads of one command.
+ * Statistics of workers are added to the profiler of the creating thread when this object is destroyed
+ * (after the workers are joined), so profilers are never shared by threads.
+ */
+class WorkerProfilers
+{
+public:
+	WorkerProfilers(uint32_t nofWorkers) : parent(Profiler::active())
+	{
+		if (parent)
+			workers.resize(nofWorkers);
+	}
+	~WorkerProfilers()
+	{
+		if (!parent)
+			return;
+		for (auto const &w : workers)
+			if (!w.getFrames().empty())
+				parent->accumulate(w.getFrames().back());
+	}
+	Profiler *get(uint32_t worker)
+	{
+		return parent ? &workers[worker] : nullptr;
+	}
+
+private:
+	Profiler *parent;
+	std::deque<Profiler> workers;
+};
+
+void report(Profiler const &p, bool printSummary, std::string const &traceFile);
+
+inline void count(Counter c, uint64_t n = 1)
+{
+	if (auto p = Profiler::active())
+		p->count(c, n);
+}
+
+} // namespace profiler
+
+#define IZG_PROFILE_CONCAT_(a, b) a##b
+#define IZG_PROFILE_CONCAT(a, b) IZG_PROFILE_CONCAT_(a, b)
+
+#ifdef IZG_PROFILING
+#define PROFILE_STAGE(stage) profiler::ScopedStage IZG_PROFILE_CONCAT(profileStage, __LINE__)(profiler::Stage::stage)
+#define PROFILE_SUBMIT() profiler::ScopedSubmit IZG_PROFILE_CONCAT(profileSubmit, __LINE__)
+#define PROFILE_COMMAND(isDraw, id) profiler::ScopedCommand IZG_PROFILE_CONCAT(profileCommand, __LINE__)(isDraw, id)
+#define PROFILE_COUNT(counter, n) profiler::count(profiler::Counter::counter, n)
+#define PROFILE_WORKERS(n) profiler::WorkerProfilers profileWorkers(n)
+#define PROFILE_WORKER(i)                                                 \
+	profiler::ActiveProfiler profileWorker(profileWorkers.get(i)); \
+	PROFILE_SUBMIT()
+#else
+#define PROFILE_STAGE(stage) ((void)0)
+#define PROFILE_SUBMIT() ((void)0)
+#define PROFILE_COMMAND(isDraw, id) ((void)(isDraw), (void)(id))
+#define PROFILE_COUNT(counter, n) ((void)0)
+#define PROFILE_WORKERS(n) ((void)0)
+#define PROFILE_WORKER(i) ((void)(i))
+#endif
@@ -0,0 +1,89 @@
+/*!
+ * @file
+ * @brief This file contains implementation of flattened scene graph.
+ */
+
+#include <student/sceneGraph.hpp>
+
+#include <algorithm>
+
+/**
+ * @brief Constructor
+ *
+ * @param roots roots of node trees
+ */
+SceneGraph::SceneGraph(std::vector<Node> const &roots)
+{
+	build(roots);
+}
+
+/**
+ * @brief This function flattens node trees and computes world matrices.
+ *
+ * @param roots roots of node trees
+ */
+void SceneGraph::build(std::vector<Node> const &roots)
+{
+	nodes.clear();
+	dirty.clear();
+	for (auto const &root : roots)
+		insert(root, -1);
+}
+
+void SceneGraph::insert(Node const &node, int32_t parent)
+{
+	auto const id = (uint32_t)nodes.size();
+	nodes.emplace_back();
+	{
+		auto &n       = nodes.back();
+		n.parent      = parent;
+		n.mesh        = node.mesh;
+		n.localMatrix = node.modelMatrix;
+		n.worldMatrix = parent < 0 ? node.modelMatrix : nodes[parent].worldMatrix * node.modelMatrix;
+	}
+	for (auto const &child : node.children)
+		insert(child, (int32_t)id);
+	nodes[id].subtreeEnd = (uint32_t)nodes.size();
+}
+
+/**
+ * @brief This function changes local matrix of node.
+ * World matrices of the node and its subtree are recomputed by the next update().
+ *
+ * @param node index of node
+ * @param matrix new local matrix
+ */
+void SceneGraph::setLocalMatrix(uint32_t node, glm::mat4 const &matrix)
+{
+	nodes.at(node).localMatrix = matrix;
+	dirty.push_back(node);
+}
+
+/**
+ * @brief This function recomputes world matrices of dirty subtrees.
+ * Subtrees are contiguous and parents precede children, so every dirty subtree is one linear pass
+ * and subtrees nested in an already recomputed one are skipped.
+ *
+ * @return true if any world matrix was recomputed
+ */
+bool SceneGraph::update()
+{
+	if (dirty.empty())
+		return false;
+	std::sort(dirty.begin(), dirty.end());
+
+	uint32_t done = 0; // nodes before this index are up to date
+	for (auto const d : dirty)
+	{
+		if (d < done)
+			continue;
+		for (uint32_t i = d; i < nodes[d].subtreeEnd; ++i)
+		{
+			auto &n       = nodes[i];
+			n.worldMatrix = n.parent < 0 ? n.localMatrix : nodes[n.parent].worldMatrix * n.localMatrix;
+		}
+		done = nodes[d].subtreeEnd;
+	}
+	dirty.clear();
+	return true;
+}
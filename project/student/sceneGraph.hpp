@@ -0,0 +1,45 @@
+/*!
+ * @file
+ * @brief This file contains flattened scene graph of a model.
+ *
+ * Node trees of Model are stored in one array in pre-order, so parents always precede their children
+ * and every subtree is a contiguous range. The graph is built once per loaded model (ModelData::getSceneGraph),
+ * traversal is a linear scan and world matrices are cached;
+ * changing a local matrix marks the node dirty and update() recomputes only dirty subtrees.
+ */
+#pragma once
+
+#include <student/fwd.hpp>
+
+#include <vector>
+
+/**
+ * @brief This struct represents one node of flattened scene graph.
+ */
+struct FlatNode
+{
+	int32_t   parent      = -1;             ///< index of parent node or -1 (root)
+	uint32_t  subtreeEnd  = 0;              ///< index after the last node of subtree of this node
+	int32_t   mesh        = -1;             ///< id of mesh or -1 if no mesh
+	glm::mat4 localMatrix = glm::mat4(1.f); ///< transformation relative to parent
+	glm::mat4 worldMatrix = glm::mat4(1.f); ///< cached parent world matrix * local matrix
+};
+
+/**
+ * @brief This class represents flattened scene graph with cached world matrices.
+ */
+class SceneGraph
+{
+public:
+	SceneGraph() {}
+	SceneGraph(std::vector<Node> const &roots);
+	void build(std::vector<Node> const &roots);
+	void setLocalMatrix(uint32_t node, glm::mat4 const &matrix);
+	bool update();
+	std::vector<FlatNode> const &getNodes() const { return nodes; } ///< nodes in pre-order
+
+private:
+	void                  insert(Node const &node, int32_t parent);
+	std::vector<FlatNode> nodes;
+	std::vector<uint32_t> dirty; ///< nodes whose local matrix changed since the last update
+};
@@ -0,0 +1,231 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+
+#include <BasicCamera/OrbitCamera.h>
+#include <BasicCamera/PerspectiveCamera.h>
+#include <examples/modelMethod.hpp>
+#include <framework/application.hpp>
+#include <framework/framebuffer.hpp>
+#include <framework/timer.hpp>
+#include <tests/batchRender.hpp>
+#include <tests/saveFrame.hpp>
+
+#include <libs/stb_image/stb_image_write.h>
+
+namespace{
+
+/**
+ * @brief One key of camera path - angles are in degrees.
+ */
+struct CameraKey{
+  float xAngle   = 0.f;
+  float yAngle   = 0.f;
+  float distance = 0.f;
+};
+
+/**
+ * @brief This function loads camera path.
+ * Every non empty line that does not start with # contains: xAngle yAngle distance (angles in degrees).
+ *
+ * @param fileName file with camera path
+ *
+ * @return camera keys
+ */
+std::vector<CameraKey>loadCameraPath(std::string const&fileName){
+  std::ifstream file(fileName);
+  if(!file.is_open())throw std::runtime_error("batch: cannot open camera path: "+fileName);
+  std::vector<CameraKey>res;
+  std::string line;
+  while(std::getline(file,line)){
+    if(line.empty() || line[0] == '#')continue;
+    std::stringstream ss(line);
+    CameraKey key;
+    if(!(ss >> key.xAngle >> key.yAngle >> key.distance))
+      throw std::runtime_error("batch: wrong camera path line: \""+line+"\"");
+    res.push_back(key);
+  }
+  return res;
+}
+
+/**
+ * @brief This function computes scene parameters of one frame.
+ * It depends only on frame index, so output does not depend on thread scheduling.
+ */
+SceneParam computeSceneParam(BatchSettings const&settings,std::vector<CameraKey>const&path,size_t frameId){
+  auto orbitCamera       = basicCamera::OrbitCamera();
+  auto perspectiveCamera = basicCamera::PerspectiveCamera();
+  glm::vec3 light;
+  defaultSceneParameters(orbitCamera,perspectiveCamera,light,settings.width,settings.height);
+
+  if(path.empty()){
+    // turntable around the default camera
+    orbitCamera.addYAngle(glm::two_pi<float>()*static_cast<float>(frameId)/static_cast<float>(settings.nofFrames));
+  }else{
+    auto const&key = path.at(frameId);
+    orbitCamera.setXAngle  (glm::radians(key.xAngle));
+    orbitCamera.setYAngle  (glm::radians(key.yAngle));
+    orbitCamera.setDistance(key.distance);
+  }
+
+  SceneParam sceneParam;
+  sceneParam.proj   = perspectiveCamera.getProjection();
+  sceneParam.view   = orbitCamera      .getView      ();
+  sceneParam.camera = glm::vec3(glm::inverse(sceneParam.view)*glm::vec4(0.f,0.f,0.f,1.f));
+  sceneParam.light  = light;
+  return sceneParam;
+}
+
+std::string frameFileName(std::string const&outputDir,size_t frameId){
+  char name[32];
+  std::snprintf(name,sizeof(name),"frame_%06zu.png",frameId);
+  return outputDir+"/"+name;
+}
+
+/**
+ * @brief Rendered frame waiting for png encoding.
+ */
+struct EncodeJob{
+  size_t              frameId;
+  std::vector<uint8_t>image  ;
+};
+
+/**
+ * @brief Bounded queue of encode jobs - rendering threads wait if i/o threads are behind.
+ */
+class EncodeQueue{
+  public:
+    EncodeQueue(size_t capacity):capacity(capacity){}
+    void push(EncodeJob&&job){
+      std::unique_lock<std::mutex>lock(mutex);
+      notFull.wait(lock,[&]{return jobs.size() < capacity;});
+      jobs.push(std::move(job));
+      notEmpty.notify_one();
+    }
+    bool pop(EncodeJob&job){
+      std::unique_lock<std::mutex>lock(mutex);
+      notEmpty.wait(lock,[&]{return !jobs.empty() || finished;});
+      if(jobs.empty())return false;
+      job = std::move(jobs.front());
+      jobs.pop();
+      notFull.notify_one();
+      return true;
+    }
+    void finish(){
+      std::unique_lock<std::mutex>lock(mutex);
+      finished = true;
+      notEmpty.notify_all();
+    }
+  private:
+    std::mutex             mutex           ;
+    std::condition_variable notFull        ;
+    std::condition_variable notEmpty       ;
+    std::queue<EncodeJob>  jobs            ;
+    size_t                 capacity        ;
+    bool                   finished = false;
+};
+
+}
+
+/**
+ * @brief This function renders image sequence of model without window.
+ * Every rendering thread has its own GPUMemory, CommandBuffer and Framebuffer (the model is loaded only once),
+ * png files are encoded by separate i/o threads.
+ * Output file frame_NNNNNN.png depends only on frame index.
+ * Every rendering thread streams textures (textureBudget) by its own frame local residency manager with the whole budget
+ * (mip tails are read once and shared), so resident levels of a frame do not depend on frames rendered before it.
+ *
+ * @param settings batch settings
+ */
+void runBatchRender(BatchSettings const&settings){
+  auto const path = settings.cameraPath.empty()?std::vector<CameraKey>{}:loadCameraPath(settings.cameraPath);
+  size_t const nofFrames = path.empty()?settings.nofFrames:path.size();
+  if(nofFrames == 0)return;
+
+  auto hwThreads = std::thread::hardware_concurrency();
+  if(hwThreads == 0)hwThreads = 4;
+  size_t const nofRenderThreads = std::min<size_t>(settings.renderThreads?settings.renderThreads:hwThreads,nofFrames);
+  size_t const nofIOThreads     = std::max<size_t>(1,settings.ioThreads?settings.ioThreads:nofRenderThreads/4);
+
+  auto modelData = std::make_shared<ModelData>();
+  modelData->load(settings.modelFile,settings.meshes,settings.lods,settings.textureBudget != 0);
+  std::cerr << modelData->getLoadTimes() << std::endl;
+  TextureResidency sharedTails;
+  if(settings.textureBudget)
+    sharedTails.init(modelData->getTextureSources(),(uint64_t)settings.textureBudget<<20);
+
+  BatchSettings frameSettings = settings;
+  frameSettings.nofFrames = nofFrames;
+
+  // contexts are created sequentially, rendering is parallel
+  std::vector<std::unique_ptr<modelMethod::Method>>methods;
+  std::vector<std::unique_ptr<Framebuffer        >>framebuffers;
+  for(size_t i=0;i<nofRenderThreads;++i){
+    modelMethod::ConstructionData cd;
+    cd.modelData = modelData;
+    if(settings.textureBudget){
+      cd.textureResidency = std::make_shared<TextureResidency>();
+      cd.textureResidency->init(sharedTails,(uint64_t)settings.textureBudget<<20,true);
+    }
+    methods     .emplace_back(std::make_unique<modelMethod::Method>(&cd));
+    framebuffers.emplace_back(std::make_unique<Framebuffer>(settings.width,settings.height,settings.samples,settings.tiled));
+  }
+
+  EncodeQueue queue(2*nofRenderThreads);
+  std::atomic<size_t>nextFrame  {0};
+  std::atomic<size_t>nofWritten {0};
+  std::atomic<bool  >writeFailed{false};
+
+  Timer<float>timer;
+  timer.reset();
+
+  std::vector<std::thread>ioThreads;
+  for(size_t i=0;i<nofIOThreads;++i)
+    ioThreads.emplace_back([&](){
+      EncodeJob job;
+      while(queue.pop(job)){
+        auto const file = frameFileName(settings.outputDir,job.frameId);
+        if(!stbi_write_png(file.c_str(),settings.width,settings.height,4,job.image.data(),0))
+          writeFailed = true;
+        auto const written = ++nofWritten;
+        if(written%100 == 0 || written == nofFrames)
+          std::cerr << "batch: " << written << "/" << nofFrames << " frames" << std::endl;
+      }
+    });
+
+  std::vector<std::thread>renderThreads;
+  for(size_t t=0;t<nofRenderThreads;++t)
+    renderThreads.emplace_back([&,t](){
+      auto&method      = *methods     [t];
+      auto&framebuffer = *framebuffers[t];
+      auto frame = framebuffer.getFrame();
+      for(size_t frameId = nextFrame++;frameId < nofFrames;frameId = nextFrame++){
+        // the frame must not depend on the previous frame rendered by this context
+        framebuffer.clear();
+
+        method.onDraw(frame,computeSceneParam(frameSettings,path,frameId));
+        framebuffer.resolve();
+
+        EncodeJob job;
+        job.frameId = frameId;
+        frameToImage(job.image,framebuffer.color.data(),frame.width,frame.height);
+        queue.push(std::move(job));
+      }
+    });
+
+  for(auto&t:renderThreads)t.join();
+  queue.finish();
+  for(auto&t:ioThreads)t.join();
+
+  auto const time = timer.elapsedFromStart();
+  std::cerr << "batch: rendered " << nofFrames << " frames (" << settings.width << "x" << settings.height << ") into \"" << settings.outputDir << "\" in " << time << " s using "
+            << nofRenderThreads << " rendering and " << nofIOThreads << " i/o threads" << std::endl;
+  if(writeFailed)
+    std::cerr << "batch: some frames could not be written into \"" << settings.outputDir << "\"" << std::endl;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include <framework/meshOptimizer.hpp>
+
+/**
+ * @brief Settings of headless batch rendering of model
+ */
+struct BatchSettings{
+  std::string modelFile           ;///< model in gltf/glb format
+  std::string outputDir           ;///< directory for frame_NNNNNN.png files (it has to exist)
+  std::string cameraPath          ;///< camera path file (empty = turntable)
+  uint32_t    width         = 500 ;///< width of frames
+  uint32_t    height        = 500 ;///< height of frames
+  size_t      nofFrames     = 360 ;///< number of frames of turntable
+  size_t      renderThreads = 0   ;///< number of rendering threads (0 = number of cores)
+  size_t      ioThreads     = 0   ;///< number of png encoding threads (0 = quarter of rendering threads)
+  uint32_t    samples       = 1   ;///< number of samples per pixel (1 or 4)
+  bool        tiled         = true;///< render into tiled framebuffer
+  MeshOptimization meshes   = MeshOptimization::NONE;///< optimization of model meshes
+  bool        lods          = false;///< generate levels of detail of model meshes
+  uint32_t    textureBudget = 0   ;///< budget of streamed textures in MiB of every rendering thread (0 = textures are fully resident)
+};
+
+void runBatchRender(BatchSettings const&settings);
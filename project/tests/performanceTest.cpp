@@ -10,11 +10,12 @@
 #include <examples/modelMethod.hpp>
 #include <framework/timer.hpp>
 #include <framework/framebuffer.hpp>
+#include <student/profiler.hpp>
 #include <tests/performanceTest.hpp>
 
 #define ___ std::cerr << __FILE__ << "/" << __LINE__ << std::endl
 
-void runPerformanceTest(size_t framesPerMeasurement) {
+void runPerformanceTest(size_t framesPerMeasurement,bool printProfile,std::string const&traceFile) {
   uint32_t width = 500;
   uint32_t height = 500;
   auto method = std::make_shared<modelMethod::Method>();
@@ -53,4 +54,16 @@ void runPerformanceTest(size_t framesPerMeasurement) {
   std::cout << "Seconds per frame: " << std::scientific << std::setprecision(10)
             << time << std::endl;
 
+  if(!printProfile && traceFile.empty())return;
+
+  // instrumented frames are measured separately so they do not skew the time above
+  profiler::Profiler prof(framesPerMeasurement);
+  profiler::ActiveProfiler activeProfiler(&prof);
+  for (size_t i   = 0; i < framesPerMeasurement; ++i){
+    prof.beginFrame();
+    method->onDraw(frame,sceneParam);
+    prof.endFrame();
+  }
+  profiler::report(prof,printProfile,traceFile);
+
 }
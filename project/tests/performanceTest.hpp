@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
-void runPerformanceTest(size_t framesPerMeasurement = 100);
+void runPerformanceTest(size_t framesPerMeasurement = 100,bool printProfile = false,std::string const&traceFile = "");
 
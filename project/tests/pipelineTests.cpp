@@ -0,0 +1,946 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <iostream>
+#include <functional>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+#include <student/gpu.hpp>
+#include <framework/framebuffer.hpp>
+#include <tests/testCommon.hpp>
+#include <tests/commandBufferToStr.hpp>
+
+using namespace tests;
+
+namespace pipelineTests{
+
+/**
+ * @brief Vertex shader of the tests - position is attribute 0, color is uniform selected by gl_DrawID.
+ * Color is darkened towards the first vertex of the draw, so it has to be interpolated.
+ */
+void vertexShaderColor(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si){
+  auto const color = si.uniforms[inVertex.gl_DrawID].v4;
+  float const shade = inVertex.gl_VertexID%3 == 0 ? .5f : 1.f;
+  outVertex.gl_Position     = glm::vec4(inVertex.attributes[0].v3,1.f);
+  outVertex.attributes[0].v4 = glm::vec4(glm::vec3(color)*shade,color.a);
+  outVertex.attributes[1].u1 = inVertex.gl_DrawID;
+}
+
+void fragmentShaderColor(OutFragment&outFragment,InFragment const&inFragment,ShaderInterface const&){
+  outFragment.gl_FragColor = inFragment.attributes[0].v4;
+}
+
+/**
+ * @brief Fragment shader that reads color of draw from uniforms using flat integer attribute.
+ */
+void fragmentShaderFlat(OutFragment&outFragment,InFragment const&inFragment,ShaderInterface const&si){
+  outFragment.gl_FragColor = si.uniforms[inFragment.attributes[1].u1].v4;
+}
+
+using Scene = std::function<void(GPUMemory&,CommandBuffer&)>;
+
+/**
+ * @brief This function renders scene into new framebuffer and returns resolved color.
+ *
+ * @param scene function that fills gpu memory and command buffer
+ * @param flags submission flags
+ * @param samples number of samples per pixel
+ * @param tiled is framebuffer tiled
+ *
+ * @return color of framebuffer
+ */
+std::vector<uint8_t>render(Scene const&scene,SubmitFlags flags,uint32_t samples = 1,bool tiled = false){
+  MEMCB();
+  auto framebuffer = std::make_shared<Framebuffer>(100,100,samples,tiled);
+  mem.framebuffer = framebuffer->getFrame();
+  scene(mem,cb);
+  gpu_execute(mem,cb,flags);
+  framebuffer->resolve();
+  return framebuffer->color;
+}
+
+/**
+ * @brief This function returns number of pixels that differ.
+ */
+uint32_t nofDifferentPixels(std::vector<uint8_t>const&a,std::vector<uint8_t>const&b){
+  uint32_t res = 0;
+  for(size_t i=0;i+3<a.size() && i+3<b.size();i+=4)
+    res += a[i] != b[i] || a[i+1] != b[i+1] || a[i+2] != b[i+2] || a[i+3] != b[i+3];
+  return res;
+}
+
+/**
+ * @brief gl_DrawID and tag (attribute 2, recorded index of draw) of executed draws in execution order.
+ */
+std::vector<glm::uvec2>executedDraws;
+
+/**
+ * @brief Vertex shader that records executed draws (see executedDraws).
+ */
+void vertexShaderRecord(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si){
+  if(inVertex.gl_VertexID == 0)executedDraws.emplace_back(inVertex.gl_DrawID,inVertex.attributes[2].u1);
+  vertexShaderColor(outVertex,inVertex,si);
+}
+
+/**
+ * @brief Input vertices of vertex shader in order of execution (see vertexShaderInputs).
+ */
+std::vector<InVertex>inVertices;
+
+/**
+ * @brief Vertex shader that records its input (see inVertices).
+ */
+void vertexShaderInputs(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&){
+  inVertices.push_back(inVertex);
+  outVertex.gl_Position = glm::vec4(0.f,0.f,0.f,1.f);
+}
+
+/**
+ * @brief Triangles of the tests, every draw uses 3 consecutive vertices (x,y,z).
+ */
+std::vector<float>const triangles = {
+  -1.0f,-1.0f,+0.5f,  +1.0f,-1.0f,+0.5f,  -1.0f,+1.0f,+0.5f, // 0 far
+  -0.8f,-0.6f,+0.0f,  +0.9f,-0.2f,+0.0f,  -0.1f,+0.9f,+0.0f, // 1 middle
+  -0.6f,-0.9f,-0.5f,  +0.6f,+0.1f,-0.5f,  -0.9f,+0.4f,-0.5f, // 2 near
+  -1.0f,-1.0f,+0.2f,  +1.0f,+1.0f,+0.2f,  -1.0f,+1.0f,+0.2f, // 3 behind near, in front of far
+};
+
+/**
+ * @brief This function pushes draw of one triangle (see triangles).
+ */
+DrawCommand&pushTriangle(CommandBuffer&cb,uint32_t triangle,int32_t prg = 0){
+  VertexArray vao;
+  vao.vertexAttrib[0].bufferID = 0;
+  vao.vertexAttrib[0].type     = AttributeType::VEC3;
+  vao.vertexAttrib[0].stride   = sizeof(float)*3;
+  vao.vertexAttrib[0].offset   = sizeof(float)*9*triangle;
+  pushDrawCommand(cb,3,prg,vao);
+  return cb.commands[cb.nofCommands-1].data.drawCommand;
+}
+
+/**
+ * @brief This function sets programs and vertex buffer of the tests.
+ */
+void setupMemory(GPUMemory&mem){
+  mem.buffers[0].data = triangles.data();
+  mem.buffers[0].size = triangles.size()*sizeof(float);
+  for(int32_t p=0;p<2;++p){
+    mem.programs[p].vertexShader = vertexShaderColor;
+    mem.programs[p].vs2fs[0]     = AttributeType::VEC4;
+    mem.programs[p].vs2fs[1]     = AttributeType::UINT;
+  }
+  mem.programs[0].fragmentShader = fragmentShaderColor;
+  mem.programs[1].fragmentShader = fragmentShaderFlat ;
+}
+
+uint32_t const gridX   = 5;          ///< number of vertices of grid in x
+uint32_t const gridY   = 4;          ///< number of vertices of grid in y
+uint32_t const restart = 0xffffffffu;///< primitive restart in index lists of the tests (converted to the index type)
+
+/**
+ * @brief This function returns vertices of grid (x,y), vertex x,y has index y*gridX+x.
+ */
+std::vector<float>gridVertices(){
+  std::vector<float>res;
+  for(uint32_t y=0;y<gridY;++y)
+    for(uint32_t x=0;x<gridX;++x){
+      res.push_back(-.9f + 1.8f*(float)x/(float)(gridX-1));
+      res.push_back(-.9f + 1.8f*(float)y/(float)(gridY-1));
+    }
+  return res;
+}
+
+/**
+ * @brief Vertex shader of grid - every vertex has different color, so wrong vertices of triangles change the image.
+ */
+void vertexShaderGrid(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&){
+  auto const id = (float)inVertex.gl_VertexID;
+  outVertex.gl_Position      = glm::vec4(inVertex.attributes[0].v2,0.f,1.f);
+  outVertex.attributes[0].v4 = glm::vec4(glm::fract(id*.37f),glm::fract(id*.61f),glm::fract(id*.13f),1.f);
+}
+
+/**
+ * @brief This function converts indices into index buffer of index type (restart is converted to the maximal value of the type).
+ */
+std::vector<uint8_t>indexBuffer(std::vector<uint32_t>const&indices,IndexType type){
+  auto const size = (size_t)type;
+  std::vector<uint8_t>res(indices.size()*size);
+  for(size_t i=0;i<indices.size();++i){
+    uint32_t const v = indices[i] == restart ? (uint32_t)((1ull<<(8*size))-1) : indices[i];
+    std::memcpy(res.data()+i*size,&v,size);// little endian
+  }
+  return res;
+}
+
+/**
+ * @brief This function renders indexed draw of grid with backface culling.
+ *
+ * @param indices indices (restart = primitive restart)
+ * @param type index type
+ * @param topology topology of the draw
+ * @param primitiveRestart is primitive restart enabled
+ *
+ * @return color of framebuffer
+ */
+std::vector<uint8_t>renderGrid(std::vector<uint32_t>const&indices,IndexType type,Topology topology,bool primitiveRestart){
+  auto const vertices = gridVertices();
+  auto const buffer   = indexBuffer(indices,type);
+  return render([&](GPUMemory&mem,CommandBuffer&cb){
+    mem.buffers[0].data = vertices.data();
+    mem.buffers[0].size = vertices.size()*sizeof(float);
+    mem.buffers[1].data = buffer.data();
+    mem.buffers[1].size = buffer.size();
+    mem.programs[0].vertexShader   = vertexShaderGrid   ;
+    mem.programs[0].fragmentShader = fragmentShaderColor;
+    mem.programs[0].vs2fs[0]       = AttributeType::VEC4;
+
+    VertexArray vao;
+    vao.vertexAttrib[0].bufferID = 0;
+    vao.vertexAttrib[0].type     = AttributeType::VEC2;
+    vao.vertexAttrib[0].stride   = sizeof(float)*2;
+    vao.indexBufferID = 1;
+    vao.indexType     = type;
+    pushClearCommand(cb,glm::vec4(.1f,.2f,.3f,1.f),1.f);
+    pushDrawCommand(cb,(uint32_t)indices.size(),0,vao,true);
+    auto&cmd = cb.commands[cb.nofCommands-1].data.drawCommand;
+    cmd.topology         = topology;
+    cmd.primitiveRestart = primitiveRestart;
+  },SubmitFlags::NONE);
+}
+
+/**
+ * @brief This function returns strip of one row of quads of grid, the first triangle is counter-clockwise.
+ */
+std::vector<uint32_t>gridRowStrip(uint32_t y){
+  std::vector<uint32_t>res;
+  for(uint32_t x=0;x<gridX;++x){
+    res.push_back((y+1)*gridX+x);
+    res.push_back((y+0)*gridX+x);
+  }
+  return res;
+}
+
+/**
+ * @brief This function returns triangles of strip gridRowStrip(y) (triangle n uses vertices n,n+1,n+2, odd triangles swap the first two).
+ */
+std::vector<uint32_t>gridRowList(uint32_t y){
+  std::vector<uint32_t>res;
+  for(uint32_t x=0;x+1<gridX;++x){
+    uint32_t const t[] = {
+      (y+1)*gridX+x  ,(y+0)*gridX+x,(y+1)*gridX+x+1,
+      (y+1)*gridX+x+1,(y+0)*gridX+x,(y+0)*gridX+x+1,
+    };
+    res.insert(res.end(),t,t+6);
+  }
+  return res;
+}
+
+/**
+ * @brief This function returns counter-clockwise fan around inner vertex x,y of grid (8 triangles).
+ */
+std::vector<uint32_t>gridFan(uint32_t x,uint32_t y){
+  int32_t const ring[][2] = {{1,0},{1,1},{0,1},{-1,1},{-1,0},{-1,-1},{0,-1},{1,-1},{1,0}};
+  std::vector<uint32_t>res = {y*gridX+x};
+  for(auto const&r:ring)res.push_back((y+r[1])*gridX+x+r[0]);
+  return res;
+}
+
+/**
+ * @brief This function returns triangles of fan (triangle n uses vertices 0,n+1,n+2).
+ */
+std::vector<uint32_t>fanList(std::vector<uint32_t>const&fan){
+  std::vector<uint32_t>res;
+  for(size_t i=1;i+1<fan.size();++i){
+    res.push_back(fan[0]  );
+    res.push_back(fan[i]  );
+    res.push_back(fan[i+1]);
+  }
+  return res;
+}
+
+template<typename T>
+std::vector<T>concat(std::initializer_list<std::vector<T>>lists){
+  std::vector<T>res;
+  for(auto const&l:lists)res.insert(res.end(),l.begin(),l.end());
+  return res;
+}
+
+/**
+ * @brief This function compares indexed draw of grid with the expected list of triangles.
+ *
+ * @param name description of the case
+ * @param indices indices of the draw
+ * @param type index type of the draw
+ * @param topology topology of the draw
+ * @param list expected triangles (empty = everything is culled)
+ *
+ * @return true if the draw renders the same image as the list
+ */
+bool checkTopology(std::string const&name,std::vector<uint32_t>const&indices,IndexType type,Topology topology,std::vector<uint32_t>const&list){
+  auto const expected = renderGrid(list   ,IndexType::UINT32,Topology::TRIANGLES,false);
+  auto const result   = renderGrid(indices,type             ,topology           ,true );
+  auto const diff = nofDifferentPixels(expected,result);
+  if(diff == 0)return true;
+
+  char const*const topologies[] = {"TRIANGLES","TRIANGLE_STRIP","TRIANGLE_FAN"};
+  std::cerr << "  " << name << std::endl;
+  std::cerr << "  topology: " << topologies[(int)topology] << " indexType: " << str(type) << std::endl;
+  std::cerr << "  indices :";
+  for(auto const i:indices)
+    if(i == restart)std::cerr << " restart";
+    else std::cerr << " " << i;
+  std::cerr << std::endl;
+  std::cerr << "  očekávané trojúhelníky:";
+  for(auto const i:list)std::cerr << " " << i;
+  std::cerr << std::endl;
+  std::cerr << "  počet rozdílných pixelů: " << diff << std::endl;
+  return false;
+}
+
+}
+
+using namespace pipelineTests;
+
+SCENARIO("43"){
+  std::cerr << "43 - visibility buffer renders the same image as normal submission" << std::endl;
+
+  // opaque draws overlap each other, translucent and alpha-cutout draws (BlendMode::AUTO) are in front of them
+  // and opaque draw behind translucent one is drawn after it
+  Scene const scene = [](GPUMemory&mem,CommandBuffer&cb){
+    setupMemory(mem);
+    glm::vec4 const colors[] = {
+      glm::vec4(1.f,0.f,0.f,1.f ),
+      glm::vec4(0.f,1.f,0.f,1.f ),
+      glm::vec4(0.f,0.f,1.f,.5f ),
+      glm::vec4(1.f,1.f,0.f,1.f ),
+      glm::vec4(1.f,0.f,1.f,.25f),
+    };
+    for(uint32_t i=0;i<5;++i)mem.uniforms[i].v4 = colors[i];
+    pushClearCommand(cb,glm::vec4(.1f,.2f,.3f,1.f),1.f);
+    pushTriangle(cb,0,0).blend = BlendMode::OFF;
+    pushTriangle(cb,1,1).blend = BlendMode::OFF;
+    pushTriangle(cb,2,0);
+    pushTriangle(cb,3,1).blend = BlendMode::OFF;
+    pushTriangle(cb,1,0);
+  };
+
+  struct Config{
+    SubmitFlags flags;
+    uint32_t    samples;
+    bool        tiled;
+  };
+  Config const configs[] = {
+    {SubmitFlags::VISIBILITY_BUFFER                                ,1,false},
+    {SubmitFlags::VISIBILITY_BUFFER | SubmitFlags::PARALLEL_SHADING,1,false},
+    {SubmitFlags::VISIBILITY_BUFFER                                ,1,true },
+    {SubmitFlags::VISIBILITY_BUFFER | SubmitFlags::PARALLEL_SHADING,4,true },
+    {SubmitFlags::VISIBILITY_BUFFER                                ,4,false},
+  };
+  for(auto const&c:configs){
+    auto const expected = render(scene,SubmitFlags::NONE,c.samples,c.tiled);
+    auto const result   = render(scene,c.flags          ,c.samples,c.tiled);
+    auto const diff = nofDifferentPixels(expected,result);
+    if(diff == 0)continue;
+
+    std::cerr << R".(
+    TEST SELHAL!
+
+    Tento test zkouší, zda SubmitFlags::VISIBILITY_BUFFER vykreslí stejný obrázek jako běžné vykreslování.
+    Scéna obsahuje překrývající se neprůhledné trojúhelníky (BlendMode::OFF)
+    a poloprůhledné trojúhelníky (BlendMode::AUTO), které musí vidět vše, co bylo nakresleno před nimi.
+    )." << std::endl;
+    std::cerr << "    flags: " << static_cast<uint32_t>(c.flags) << " samples: " << c.samples << " tiled: " << str(c.tiled) << std::endl;
+    std::cerr << "    počet rozdílných pixelů: " << diff << std::endl;
+    MEMCB();
+    scene(mem,cb);
+    std::cerr << commandBufferToStr(4,cb);
+    REQUIRE(false);
+  }
+}
+
+SCENARIO("44"){
+  std::cerr << "44 - sorted draws keep order of blended draws and their gl_DrawID" << std::endl;
+
+  // every draw has its recorded index in attribute 2 (stride 0)
+  std::vector<uint32_t>const tags = {0,1,2,3,4,5};
+  Scene const scene = [&](GPUMemory&mem,CommandBuffer&cb){
+    setupMemory(mem);
+    mem.buffers[1].data = tags.data();
+    mem.buffers[1].size = tags.size()*sizeof(uint32_t);
+    for(int32_t p=0;p<2;++p)mem.programs[p].vertexShader = vertexShaderRecord;
+    glm::vec4 const colors[] = {
+      glm::vec4(1.f,0.f,0.f,1.f ),
+      glm::vec4(0.f,1.f,0.f,1.f ),
+      glm::vec4(0.f,0.f,1.f,.5f ),
+      glm::vec4(1.f,1.f,0.f,.25f),
+      glm::vec4(0.f,1.f,1.f,1.f ),
+      glm::vec4(1.f,0.f,1.f,1.f ),
+    };
+    for(uint32_t i=0;i<6;++i)mem.uniforms[i].v4 = colors[i];
+
+    struct Draw{
+      uint32_t  triangle;
+      int32_t   prg;
+      BlendMode blend;
+      uint32_t  sortState;
+      float     sortDepth;
+    };
+    Draw const draws[] = {
+      {0,0,BlendMode::OFF  ,2,3.f},
+      {1,0,BlendMode::OFF  ,1,2.f},
+      {2,0,BlendMode::AUTO ,0,0.f},
+      {3,0,BlendMode::ALPHA,0,0.f},
+      {3,1,BlendMode::OFF  ,1,0.f},
+      {0,0,BlendMode::OFF  ,0,1.f},
+    };
+    pushClearCommand(cb,glm::vec4(.1f,.2f,.3f,1.f),1.f);
+    for(uint32_t d=0;d<6;++d){
+      auto&cmd = pushTriangle(cb,draws[d].triangle,draws[d].prg);
+      cmd.blend     = draws[d].blend    ;
+      cmd.sortState = draws[d].sortState;
+      cmd.sortDepth = draws[d].sortDepth;
+      cmd.vao.vertexAttrib[2].bufferID = 1;
+      cmd.vao.vertexAttrib[2].type     = AttributeType::UINT;
+      cmd.vao.vertexAttrib[2].stride   = 0;
+      cmd.vao.vertexAttrib[2].offset   = sizeof(uint32_t)*d;
+    }
+  };
+
+  executedDraws.clear();
+  auto const expected = render(scene,SubmitFlags::NONE);
+  executedDraws.clear();
+  auto const result   = render(scene,SubmitFlags::SORT_DRAWS);
+
+  // runs of opaque draws are sorted by program and state: 1 0 | 2 | 3 | 5 4
+  std::vector<uint32_t>const expectedOrder = {1,0,2,3,5,4};
+  bool wrong = executedDraws.size() != expectedOrder.size() || nofDifferentPixels(expected,result) != 0;
+  for(size_t i=0;i<executedDraws.size() && !wrong;++i)
+    wrong |= executedDraws[i].x != executedDraws[i].y || executedDraws[i].y != expectedOrder[i];
+
+  if(!wrong)return;
+
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test zkouší SubmitFlags::SORT_DRAWS.
+  Řadit se smí pouze neprůhledné kreslící příkazy (BlendMode::OFF) mezi příkazy, které míchají barvy,
+  míchající příkazy (BlendMode::AUTO, ALPHA) musí zůstat na svém místě.
+  gl_DrawID každého příkazu musí odpovídat jeho pořadí v command bufferu, ne pořadí vykonání.
+
+  Očekávané pořadí vykonání (gl_DrawID): 1 0 2 3 5 4
+  Takto to dopadlo (gl_DrawID/pořadí v command bufferu):
+  ).";
+  for(auto const&d:executedDraws)std::cerr << " " << d.x << "/" << d.y;
+  std::cerr << std::endl;
+  std::cerr << "  počet rozdílných pixelů: " << nofDifferentPixels(expected,result) << std::endl;
+  MEMCB();
+  scene(mem,cb);
+  std::cerr << commandBufferToStr(2,cb);
+  REQUIRE(false);
+}
+
+SCENARIO("45"){
+  std::cerr << "45 - triangle strip and fan winding with backface culling" << std::endl;
+
+  auto reversed = [](std::vector<uint32_t>v){std::reverse(v.begin()+1,v.end());return v;};
+  std::vector<uint32_t>cwStrip;
+  for(uint32_t x=0;x<gridX;++x){
+    cwStrip.push_back(x);
+    cwStrip.push_back(gridX+x);
+  }
+
+  bool ok = true;
+  ok &= checkTopology("counter-clockwise strip",gridRowStrip(0),IndexType::UINT32,Topology::TRIANGLE_STRIP,gridRowList(0));
+  ok &= checkTopology("clockwise strip is culled",cwStrip,IndexType::UINT32,Topology::TRIANGLE_STRIP,{});
+  ok &= checkTopology("counter-clockwise fan",gridFan(1,1),IndexType::UINT32,Topology::TRIANGLE_FAN,fanList(gridFan(1,1)));
+  ok &= checkTopology("clockwise fan is culled",reversed(gridFan(1,1)),IndexType::UINT32,Topology::TRIANGLE_FAN,{});
+  if(ok)return;
+
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test zkouší pořadí vrcholů trojúhelníků v Topology::TRIANGLE_STRIP a TRIANGLE_FAN.
+  Trojúhelník n pásu (strip) používá vrcholy n,n+1,n+2, liché trojúhelníky prohazují první dva vrcholy,
+  takže všechny trojúhelníky pásu mají stejnou orientaci jako první trojúhelník.
+  Trojúhelník n vějíře (fan) používá vrcholy 0,n+1,n+2.
+  Ořezávání odvrácených trojúhelníků (backface culling) je zapnuté.
+  ).";
+  REQUIRE(false);
+}
+
+SCENARIO("46"){
+  std::cerr << "46 - primitive restart in 8, 16 and 32 bit index buffers" << std::endl;
+
+  auto const strips = concat<uint32_t>({gridRowStrip(0),{restart},gridRowStrip(1),{restart},gridRowStrip(2)});
+  auto const list   = concat<uint32_t>({gridRowList (0),          gridRowList (1),          gridRowList (2)});
+  auto const fans   = concat<uint32_t>({gridFan(1,1),{restart},gridFan(3,2)});
+  auto const fanTri = concat<uint32_t>({fanList(gridFan(1,1)),fanList(gridFan(3,2))});
+
+  bool ok = true;
+  for(auto const type:{IndexType::UINT8,IndexType::UINT16,IndexType::UINT32}){
+    ok &= checkTopology("strips separated by restart",strips,type,Topology::TRIANGLE_STRIP,list  );
+    ok &= checkTopology("fans separated by restart"  ,fans  ,type,Topology::TRIANGLE_FAN  ,fanTri);
+  }
+  if(ok)return;
+
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test zkouší DrawCommand::primitiveRestart.
+  Index s maximální hodnotou typu indexu (0xff, 0xffff, 0xffffffff) ukončí pás/vějíř
+  a další index začíná nový pás/vějíř.
+  ).";
+  REQUIRE(false);
+}
+
+SCENARIO("47"){
+  std::cerr << "47 - primitive restart at the start and at the end of index buffer" << std::endl;
+
+  std::vector<uint32_t>const R = {restart};
+  auto const list0 = gridRowList(0);
+  auto const list1 = gridRowList(1);
+  // triangles of a list that are interrupted by restart are dropped
+  std::vector<uint32_t>const brokenList = concat<uint32_t>({{list0[0],list0[1]},R,list1});
+
+  bool ok = true;
+  for(auto const type:{IndexType::UINT16,IndexType::UINT32}){
+    ok &= checkTopology("restart at the end of strip"        ,concat<uint32_t>({gridRowStrip(0),R})              ,type,Topology::TRIANGLE_STRIP,list0);
+    ok &= checkTopology("restart at the start of strip"      ,concat<uint32_t>({R,gridRowStrip(0)})              ,type,Topology::TRIANGLE_STRIP,list0);
+    ok &= checkTopology("consecutive restarts"               ,concat<uint32_t>({gridRowStrip(0),R,R,gridRowStrip(1),R}),type,Topology::TRIANGLE_STRIP,concat<uint32_t>({list0,list1}));
+    ok &= checkTopology("restart at the end of fan"          ,concat<uint32_t>({gridFan(1,1),R})                 ,type,Topology::TRIANGLE_FAN  ,fanList(gridFan(1,1)));
+    ok &= checkTopology("restart at the end of triangle list",concat<uint32_t>({list0,R})                        ,type,Topology::TRIANGLES     ,list0);
+    ok &= checkTopology("restart inside of triangle list"    ,brokenList                                         ,type,Topology::TRIANGLES     ,list1);
+  }
+  if(ok)return;
+
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test zkouší DrawCommand::primitiveRestart na začátku a na konci index bufferu.
+  Restart na konci nesmí vytvořit žádný trojúhelník ani číst za koncem bufferu,
+  nedokončený trojúhelník seznamu (TRIANGLES) před restartem se zahodí.
+  ).";
+  REQUIRE(false);
+}
+
+SCENARIO("48"){
+  std::cerr << "48 - vertex shader, normalized integer and half float attributes" << std::endl;
+
+  /**
+   * Attribute of 3 vertices: raw values of components and decoded values that the vertex shader should receive.
+   * Signed normalized values are divided by maximal value and clamped to -1 (-128 is -1 like -127),
+   * unsigned normalized values are divided by maximal value, half floats are converted exactly.
+   */
+  struct Case{
+    AttributeType         type   ;
+    std::vector<int32_t>  raw    ;
+    std::vector<glm::vec4>decoded;
+  };
+  std::vector<Case>const cases = {
+    {AttributeType::SNORM8_VEC4 ,{127,-127,-128,0,  64,-64,1,-1,  0,0,0,127},
+      {{1.f,-1.f,-1.f,0.f},{64.f/127.f,-64.f/127.f,1.f/127.f,-1.f/127.f},{0.f,0.f,0.f,1.f}}},
+    {AttributeType::SNORM8      ,{-100,  100,  -1},
+      {{-100.f/127.f,0,0,0},{100.f/127.f,0,0,0},{-1.f/127.f,0,0,0}}},
+    {AttributeType::UNORM8_VEC3 ,{255,0,51,  128,1,254,  0,0,0},
+      {{1.f,0.f,.2f,0},{128.f/255.f,1.f/255.f,254.f/255.f,0},{0.f,0.f,0.f,0}}},
+    {AttributeType::UNORM8_VEC2 ,{17,34,  255,255,  3,0},
+      {{17.f/255.f,34.f/255.f,0,0},{1.f,1.f,0,0},{3.f/255.f,0.f,0,0}}},
+    {AttributeType::SNORM16_VEC2,{32767,-32768,  -32767,16384,  0,1},
+      {{1.f,-1.f,0,0},{-1.f,16384.f/32767.f,0,0},{0.f,1.f/32767.f,0,0}}},
+    {AttributeType::SNORM16_VEC3,{-1000,2000,-3000,  32767,32767,32767,  -32768,0,5},
+      {{-1000.f/32767.f,2000.f/32767.f,-3000.f/32767.f,0},{1.f,1.f,1.f,0},{-1.f,0.f,5.f/32767.f,0}}},
+    {AttributeType::UNORM16     ,{65535,  0,  13107},
+      {{1.f,0,0,0},{0.f,0,0,0},{.2f,0,0,0}}},
+    {AttributeType::UNORM16_VEC4,{1,2,3,4,  65535,0,65535,0,  32768,16384,8192,4096},
+      {{1.f/65535.f,2.f/65535.f,3.f/65535.f,4.f/65535.f},{1.f,0.f,1.f,0.f},{32768.f/65535.f,16384.f/65535.f,8192.f/65535.f,4096.f/65535.f}}},
+    // 1, -2, 1/3 rounded, the smallest denormal | 0, -0, the largest half, 0.5 | pi rounded, -1, the smallest normal, the largest denormal
+    {AttributeType::HALF_VEC4   ,{0x3c00,0xc000,0x3555,0x0001,  0x0000,0x8000,0x7bff,0x3800,  0x4248,0xbc00,0x0400,0x03ff},
+      {{1.f,-2.f,.333251953125f,5.9604644775390625e-8f},{0.f,-0.f,65504.f,.5f},{3.140625f,-1.f,6.103515625e-5f,6.097555160522461e-5f}}},
+    {AttributeType::HALF_VEC2   ,{0x4500,0x5640,  0xb800,0x0200,  0x3e00,0xc900},
+      {{5.f,100.f,0,0},{-.5f,3.0517578125e-5f,0,0},{1.5f,-10.f,0,0}}},
+  };
+
+  // every attribute has its own buffer, values are not aligned and the stride has a gap of 3 bytes
+  uint64_t const offset = 1;
+  std::vector<std::vector<uint8_t>>buffers;
+  for(auto const&c:cases){
+    auto const n      = attributeTypeComponents(c.type);
+    auto const size   = attributeTypeSize(c.type);
+    auto const stride = size+3;
+    std::vector<uint8_t>buffer(offset+3*stride,0xcd);
+    for(uint32_t v=0;v<3;++v)
+      for(uint32_t k=0;k<n;++k){
+        auto const value = c.raw.at(v*n+k);
+        std::memcpy(buffer.data()+offset+v*stride+k*(size/n),&value,size/n);// little endian
+      }
+    buffers.push_back(buffer);
+  }
+
+  // cases are drawn in groups of maxAttributes, received[case][vertex] is input of vertex shader
+  std::vector<std::vector<glm::vec4>>received(cases.size());
+  for(size_t first=0;first<cases.size();first+=maxAttributes){
+    MEMCB();
+    auto framebuffer = std::make_shared<Framebuffer>(100,100);
+    mem.framebuffer = framebuffer->getFrame();
+    mem.programs[0].vertexShader   = vertexShaderInputs ;
+    mem.programs[0].fragmentShader = fragmentShaderColor;
+    VertexArray vao;
+    for(size_t a=0;a<maxAttributes && first+a<cases.size();++a){
+      auto const size = attributeTypeSize(cases[first+a].type);
+      mem.buffers[a].data = buffers[first+a].data();
+      mem.buffers[a].size = buffers[first+a].size();
+      vao.vertexAttrib[a].bufferID = (int32_t)a;
+      vao.vertexAttrib[a].type     = cases[first+a].type;
+      vao.vertexAttrib[a].stride   = size+3;
+      vao.vertexAttrib[a].offset   = offset;
+    }
+    pushDrawCommand(cb,3,0,vao);
+
+    inVertices.clear();
+    gpu_execute(mem,cb);
+    for(size_t a=0;a<maxAttributes && first+a<cases.size();++a)
+      for(auto const&v:inVertices)received[first+a].push_back(v.attributes[a].v4);
+  }
+
+  // 1/65535 and denormals are below floatErr, so values are compared relatively
+  auto const same = [](float a,float b){return a == b || std::abs(a-b) <= std::abs(b)*1e-6f;};
+  bool wrong = false;
+  for(size_t a=0;a<cases.size();++a){
+    wrong |= received[a].size() != 3;
+    for(size_t v=0;v<received[a].size() && v<3;++v)
+      for(uint32_t k=0;k<attributeTypeComponents(cases[a].type);++k)
+        wrong |= !same(received[a][v][k],cases[a].decoded[v][k]);
+  }
+
+  if(!wrong)return;
+
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test zkouší čtení normalizovaných celočíselných atributů (SNORM8, UNORM8, SNORM16, UNORM16)
+  a atributů s polovičními floaty (HALF) z vertex bufferu.
+  Atributy jsou ve vertex shaderu převedeny na floaty.
+  Signed hodnoty se dělí maximem typu a ořezávají na -1, unsigned hodnoty se dělí maximem typu.
+  ).";
+  for(size_t a=0;a<cases.size();++a){
+    std::cerr << std::endl << "  atribut " << a << " " << str(cases[a].type) << std::endl;
+    for(size_t v=0;v<3;++v){
+      std::cerr << "    vertex " << v << " očekáváno: " << str(cases[a].decoded[v]);
+      if(v < received[a].size())std::cerr << " obdrženo: " << str(received[a][v]);
+      std::cerr << std::endl;
+    }
+  }
+  REQUIRE(false);
+}
+
+namespace pipelineTests{
+
+/**
+ * @brief Vertex shader of one triangle that covers the whole frame (depth 0), color is uniform 0.
+ */
+void vertexShaderFullscreen(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si){
+  glm::vec2 const positions[] = {{-1.f,-1.f},{3.f,-1.f},{-1.f,3.f}};
+  outVertex.gl_Position      = glm::vec4(positions[inVertex.gl_VertexID%3],0.f,1.f);
+  outVertex.attributes[0].v4 = si.uniforms[0].v4;
+}
+
+bool passesDepthFunc(DepthFunc func,float inDepth,float depth){
+  switch(func){
+    case DepthFunc::NEVER   :return false;
+    case DepthFunc::LESS    :return inDepth <  depth;
+    case DepthFunc::LEQUAL  :return inDepth <= depth;
+    case DepthFunc::EQUAL   :return inDepth == depth;
+    case DepthFunc::GREATER :return inDepth >  depth;
+    case DepthFunc::GEQUAL  :return inDepth >= depth;
+    case DepthFunc::NOTEQUAL:return inDepth != depth;
+    default                 :return true;
+  }
+}
+
+/**
+ * @brief This function computes color of pixel after blending of fragment (see BlendMode).
+ */
+glm::vec4 blendColor(BlendMode blend,glm::vec4 const&frameColor,glm::vec4 const&fragColor){
+  auto const c = glm::clamp(fragColor,0.f,1.f);
+  switch(blend){
+    case BlendMode::OFF     :return c;
+    case BlendMode::ALPHA   :return glm::mix(frameColor,c,c.a);
+    case BlendMode::ADDITIVE:return glm::min(frameColor+c*c.a,glm::vec4(1.f));
+    default                 :return fragColor.a < 1.f ? glm::clamp(glm::mix(frameColor,c,fragColor.a),0.f,1.f) : c;
+  }
+}
+
+}
+
+SCENARIO("49"){
+  std::cerr << "49 - blend modes and depth functions" << std::endl;
+
+  BlendMode const blends[] = {BlendMode::AUTO,BlendMode::OFF,BlendMode::ALPHA,BlendMode::ADDITIVE};
+  DepthFunc const funcs [] = {DepthFunc::NEVER,DepthFunc::LESS,DepthFunc::LEQUAL,DepthFunc::EQUAL,DepthFunc::GREATER,DepthFunc::GEQUAL,DepthFunc::NOTEQUAL,DepthFunc::ALWAYS};
+  char const*const blendNames[] = {"AUTO","OFF","ALPHA","ADDITIVE"};
+  char const*const funcNames [] = {"NEVER","LESS","LEQUAL","EQUAL","GREATER","GEQUAL","NOTEQUAL","ALWAYS"};
+  float const alphas[] = {1.f,.75f,.25f};
+  // fragments have depth 0, framebuffer depth is less, equal and greater in every 3 columns
+  float const depths[] = {-.5f,0.f,.5f};
+  // 16 pixels wide frame uses rows of 8 fragments, 13 pixels wide frame ends with incomplete row
+  uint32_t const widths[] = {16,13};
+  uint32_t const height   = 3;
+
+  for(auto const width     :widths)
+  for(auto const blend     :blends)
+  for(auto const func      :funcs )
+  for(auto const depthTest :{true,false})
+  for(auto const depthWrite:{true,false})
+  for(auto const alpha     :alphas){
+    MEMCB();
+    auto framebuffer = std::make_shared<Framebuffer>(width,height);
+    mem.framebuffer = framebuffer->getFrame();
+    for(uint32_t y=0;y<height;++y)
+      for(uint32_t x=0;x<width;++x){
+        writeColor(mem.framebuffer,glm::uvec2(x,y),glm::uvec4(x*15,y*60+10,200,255));
+        writeDepth(mem.framebuffer,glm::uvec2(x,y),depths[x%3]);
+      }
+    auto const before      = framebuffer->color;
+    auto const beforeDepth = framebuffer->depth;
+
+    auto const fragColor = glm::vec4(.6f,.4f,.2f,alpha);
+    mem.uniforms[0].v4 = fragColor;
+    mem.programs[0].vertexShader   = vertexShaderFullscreen;
+    mem.programs[0].fragmentShader = fragmentShaderColor   ;
+    mem.programs[0].vs2fs[0]       = AttributeType::VEC4   ;
+    pushDrawCommand(cb,3,0);
+    auto&cmd = cb.commands[0].data.drawCommand;
+    cmd.blend      = blend     ;
+    cmd.depthFunc  = func      ;
+    cmd.depthTest  = depthTest ;
+    cmd.depthWrite = depthWrite;
+
+    gpu_execute(mem,cb);
+
+    bool wrong = false;
+    glm::uvec2 wrongPixel;
+    glm::uvec4 expectedColor;
+    float      expectedDepth = 0.f;
+    for(uint32_t y=0;y<height && !wrong;++y)
+      for(uint32_t x=0;x<width && !wrong;++x){
+        auto const i           = y*width+x;
+        auto const frameColor  = glm::vec4(before[4*i],before[4*i+1],before[4*i+2],before[4*i+3])/255.f;
+        auto const pass        = !depthTest || passesDepthFunc(func,0.f,beforeDepth[i]);
+        expectedColor = pass ? floatColorToBytes(blendColor(blend,frameColor,fragColor)) : glm::uvec4(glm::vec4(frameColor)*255.f+.5f);
+        expectedDepth = pass && depthTest && depthWrite && (blend != BlendMode::AUTO || alpha > .5f) ? 0.f : beforeDepth[i];
+        auto const color = getColor(mem.framebuffer,glm::uvec2(x,y));
+        // blending may round differently by one
+        for(int c=0;c<4;++c)wrong |= std::abs((int)color[c]-(int)expectedColor[c]) > 1;
+        wrong |= getDepth(mem.framebuffer,glm::uvec2(x,y)) != expectedDepth;
+        if(wrong)wrongPixel = glm::uvec2(x,y);
+      }
+    if(!wrong)continue;
+
+    std::cerr << R".(
+    TEST SELHAL!
+
+    Tento test zkouší všechny kombinace BlendMode, DepthFunc, depthTest a depthWrite.
+    Fragment prošel hloubkovým testem, pokud DepthFunc(hloubka fragmentu, hloubka ve framebufferu) platí,
+    vypnutý hloubkový test propustí všechny fragmenty a nezapisuje hloubku.
+    BlendMode::AUTO míchá fragmenty s alpha < 1 a zapisuje hloubku pouze pro alpha > 0.5.
+    )." << std::endl;
+    std::cerr << "    šířka: " << width << " blend: " << blendNames[(int)blend] << " depthFunc: " << funcNames[(int)func];
+    std::cerr << " depthTest: " << str(depthTest) << " depthWrite: " << str(depthWrite) << " barva fragmentu: " << str(fragColor) << std::endl;
+    std::cerr << "    pixel: " << str(wrongPixel) << " hloubka ve framebufferu před kreslením: " << beforeDepth[wrongPixel.y*width+wrongPixel.x] << std::endl;
+    std::cerr << "    barva: " << str(getColor(mem.framebuffer,wrongPixel)) << " očekáváno: " << str(expectedColor) << std::endl;
+    std::cerr << "    hloubka: " << getDepth(mem.framebuffer,wrongPixel) << " očekáváno: " << expectedDepth << std::endl;
+    REQUIRE(false);
+  }
+}
+
+namespace pipelineTests{
+
+/**
+ * @brief Vertex shader of triangle that covers lower left half of the frame, color is uniform 0.
+ */
+void vertexShaderHalf(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&si){
+  glm::vec2 const positions[] = {{-1.f,-1.f},{1.f,-1.f},{-1.f,1.f}};
+  outVertex.gl_Position      = glm::vec4(positions[inVertex.gl_VertexID%3],0.f,1.f);
+  outVertex.attributes[0].v4 = si.uniforms[0].v4;
+}
+
+}
+
+SCENARIO("50"){
+  std::cerr << "50 - 4x multisampling coverage and resolve" << std::endl;
+
+  // rotated grid sample positions within pixel
+  glm::vec2 const samplePositions[] = {{.375f,.125f},{.875f,.375f},{.125f,.625f},{.625f,.875f}};
+  uint32_t const size = 16;
+
+  for(auto const tiled:{false,true}){
+    MEMCB();
+    auto framebuffer = std::make_shared<Framebuffer>(size,size,4,tiled);
+    mem.framebuffer = framebuffer->getFrame();
+    mem.uniforms[0].v4 = glm::vec4(1.f);
+    mem.programs[0].vertexShader   = vertexShaderHalf   ;
+    mem.programs[0].fragmentShader = fragmentShaderColor;
+    mem.programs[0].vs2fs[0]       = AttributeType::VEC4;
+    pushDrawCommand(cb,3,0);
+    gpu_execute(mem,cb);
+
+    bool wrong = false;
+    std::string what;
+    glm::uvec2 wrongPixel;
+    uint32_t value = 0,expected = 0;
+
+    // triangle covers samples below the diagonal x+y = size of the screen, no sample lies on it
+    if(!tiled){
+      // samples of pixel are next to each other in linear multisampled frame
+      for(uint32_t y=0;y<size && !wrong;++y)
+        for(uint32_t x=0;x<size && !wrong;++x)
+          for(uint32_t s=0;s<4 && !wrong;++s){
+            bool const covered = x+samplePositions[s].x+y+samplePositions[s].y < (float)size;
+            value    = mem.framebuffer.color[4*((y*size+x)*4+s)];
+            expected = covered ? 255 : 0;
+            wrong    = value != expected;
+            if(wrong){
+              wrongPixel = glm::uvec2(x,y);
+              what = "vzorek " + std::to_string(s);
+            }
+          }
+    }
+
+    framebuffer->resolve();
+    for(uint32_t y=0;y<size && !wrong;++y)
+      for(uint32_t x=0;x<size && !wrong;++x){
+        uint32_t covered = 0;
+        for(auto const&p:samplePositions)covered += x+p.x+y+p.y < (float)size;
+        value    = framebuffer->color[4*(y*size+x)];
+        expected = (covered*255+2)/4;
+        wrong    = value != expected;
+        if(wrong){
+          wrongPixel = glm::uvec2(x,y);
+          what = "výsledná barva (pokryto vzorků: " + std::to_string(covered) + ")";
+        }
+      }
+    if(!wrong)continue;
+
+    std::cerr << R".(
+    TEST SELHAL!
+
+    Tento test kreslí bílý trojúhelník přes levou dolní polovinu 4x multisamplovaného framebufferu.
+    Fragment se zapisuje pouze do vzorků, které trojúhelník pokrývá.
+    Pozice vzorků v pixelu jsou (0.375,0.125), (0.875,0.375), (0.125,0.625), (0.625,0.875).
+    Výsledná barva pixelu je průměr vzorků: (součet+2)/4.
+    )." << std::endl;
+    std::cerr << "    tiled: " << str(tiled) << " pixel: " << str(wrongPixel) << " " << what << std::endl;
+    std::cerr << "    červená: " << value << " očekáváno: " << expected << std::endl;
+    REQUIRE(false);
+  }
+}
+
+namespace pipelineTests{
+
+/**
+ * @brief Vertex shader of triangles with position (attribute 0) and color (attribute 1) in vertex buffer.
+ */
+void vertexShaderBuffer(OutVertex&outVertex,InVertex const&inVertex,ShaderInterface const&){
+  outVertex.gl_Position      = glm::vec4(inVertex.attributes[0].v2,0.f,1.f);
+  outVertex.attributes[0].v4 = inVertex.attributes[1].v4;
+}
+
+/**
+ * @brief This function tests if pixel center is inside of triangle or on its edge (exact for positions in 1/8 of pixel).
+ */
+bool coversCenter(glm::vec2 const*p,glm::uvec2 const&pixel){
+  glm::dvec2 const c = glm::dvec2(pixel)+.5;
+  auto const edge = [&](glm::vec2 const&a,glm::vec2 const&b){
+    return (double)(b.x-a.x)*(c.y-a.y)-(double)(b.y-a.y)*(c.x-a.x);
+  };
+  double const area = (double)(p[1].x-p[0].x)*(p[2].y-p[0].y)-(double)(p[1].y-p[0].y)*(p[2].x-p[0].x);
+  if(area == 0.)return false;
+  double const s = area > 0. ? 1. : -1.;
+  return s*edge(p[0],p[1]) >= 0. && s*edge(p[1],p[2]) >= 0. && s*edge(p[2],p[0]) >= 0.;
+}
+
+}
+
+SCENARIO("52"){
+  std::cerr << "52 - small triangles keep draw order" << std::endl;
+
+  // triangles of at most 2x2 pixels are binned, every 25th triangle is larger and it is rasterized between them
+  uint32_t const size         = 16;
+  uint32_t const nofTriangles = 400;
+  std::vector<glm::vec2>positions;// in pixels, multiples of 1/8
+  std::vector<glm::vec4>colors   ;// id of triangle in 4 bit channels
+  uint32_t seed = 7;
+  auto const random = [&](uint32_t n){seed = seed*1103515245u+12345u;return (seed>>16)%n;};
+  for(uint32_t t=0;t<nofTriangles;++t){
+    uint32_t const extent = t%25 == 24 ? 96 : 14;
+    glm::vec2 const anchor = glm::vec2(random(size*8),random(size*8))/8.f;
+    for(uint32_t v=0;v<3;++v)
+      positions.push_back(anchor+glm::vec2(random(extent+1),random(extent+1))/8.f);
+    uint32_t const id = t+1;
+    for(uint32_t v=0;v<3;++v)
+      colors.emplace_back((id&15)/16.f,((id>>4)&15)/16.f,((id>>8)&15)/16.f,1.f);
+  }
+
+  // the last triangle that covers pixel center gives the color of pixel
+  std::vector<uint32_t>expected(size*size,0);
+  for(uint32_t t=0;t<nofTriangles;++t)
+    for(uint32_t y=0;y<size;++y)
+      for(uint32_t x=0;x<size;++x)
+        if(coversCenter(positions.data()+3*t,glm::uvec2(x,y)))expected[y*size+x] = t+1;
+
+  std::vector<glm::vec2>ndc;
+  for(auto const&p:positions)ndc.push_back(p/(size/2.f)-1.f);
+
+  for(auto const blend:{BlendMode::OFF,BlendMode::AUTO})
+  for(auto const tiled:{false,true}){
+    MEMCB();
+    auto framebuffer = std::make_shared<Framebuffer>(size,size,1,tiled);
+    mem.framebuffer = framebuffer->getFrame();
+    mem.buffers[0].data = ndc   .data();
+    mem.buffers[0].size = ndc   .size()*sizeof(glm::vec2);
+    mem.buffers[1].data = colors.data();
+    mem.buffers[1].size = colors.size()*sizeof(glm::vec4);
+    mem.programs[0].vertexShader   = vertexShaderBuffer ;
+    mem.programs[0].fragmentShader = fragmentShaderColor;
+    mem.programs[0].vs2fs[0]       = AttributeType::VEC4;
+    VertexArray vao;
+    vao.vertexAttrib[0].bufferID = 0;
+    vao.vertexAttrib[0].type     = AttributeType::VEC2;
+    vao.vertexAttrib[0].stride   = sizeof(glm::vec2);
+    vao.vertexAttrib[1].bufferID = 1;
+    vao.vertexAttrib[1].type     = AttributeType::VEC4;
+    vao.vertexAttrib[1].stride   = sizeof(glm::vec4);
+    pushDrawCommand(cb,3*nofTriangles,0,vao);
+    cb.commands[0].data.drawCommand.blend     = blend;
+    cb.commands[0].data.drawCommand.depthTest = false;
+    gpu_execute(mem,cb);
+    framebuffer->resolve();
+
+    bool wrong = false;
+    glm::uvec2 wrongPixel;
+    glm::uvec4 color,expectedColor;
+    for(uint32_t y=0;y<size && !wrong;++y)
+      for(uint32_t x=0;x<size && !wrong;++x){
+        auto const id = expected[y*size+x];
+        expectedColor = id ? glm::uvec4((id&15)*255/16,((id>>4)&15)*255/16,((id>>8)&15)*255/16,255) : glm::uvec4(0,0,0,255);
+        uint8_t const*c = framebuffer->color.data()+4*(y*size+x);
+        color = glm::uvec4(c[0],c[1],c[2],c[3]);
+        wrong = color != expectedColor;
+        if(wrong)wrongPixel = glm::uvec2(x,y);
+      }
+    if(!wrong)continue;
+
+    std::cerr << R".(
+    TEST SELHAL!
+
+    Tento test kreslí jedním příkazem 400 malých trojúhelníků (nejvýše 2x2 pixely), mezi nimiž jsou větší trojúhelníky.
+    Test hloubky je vypnutý, pixel má barvu posledního trojúhelníku, který pokrývá jeho střed.
+    Malé trojúhelníky se tedy musí rasterizovat ve stejném pořadí jako ostatní.
+    )." << std::endl;
+    std::cerr << "    blend: " << (blend == BlendMode::OFF ? "OFF" : "AUTO") << " tiled: " << str(tiled) << " pixel: " << str(wrongPixel) << std::endl;
+    std::cerr << "    barva: " << str(color) << " očekáváno: " << str(expectedColor) << std::endl;
+    REQUIRE(false);
+  }
+}
@@ -0,0 +1,56 @@
+#include <iomanip>
+#include <iostream>
+
+#include <framework/frameCapture.hpp>
+#include <framework/framebuffer.hpp>
+#include <framework/timer.hpp>
+#include <student/profiler.hpp>
+#include <tests/replayCapture.hpp>
+#include <tests/saveFrame.hpp>
+
+/**
+ * @brief This function replays frame capture without window and without the method that recorded it.
+ *
+ * @param captureFile capture file (see FrameCapture)
+ * @param nofReplays how many times the frame is executed
+ * @param printProfile should the gpu profile be printed
+ * @param traceFile chrome trace file or empty string
+ * @param imageFile if it is not empty, the final frame is stored into this png file
+ */
+void replayCapture(std::string const&captureFile,size_t nofReplays,bool printProfile,std::string const&traceFile,std::string const&imageFile){
+  FrameCapture capture;
+  capture.load(captureFile);
+  if(capture.submits.empty()){
+    std::cerr << "capture: \"" << captureFile << "\" does not contain any submission" << std::endl;
+    return;
+  }
+
+  auto const&first = capture.submits.front();
+  auto framebuffer = std::make_shared<Framebuffer>(first.width,first.height,first.samples,first.tiled);
+  auto frame = framebuffer->getFrame();
+
+  profiler::Profiler prof(nofReplays);
+  bool const profiling = printProfile || !traceFile.empty();
+
+  float time = 0.f;
+  Timer<float>timer;
+  for(size_t i=0;i<nofReplays;++i){
+    profiler::ActiveProfiler activeProfiler(profiling?&prof:nullptr);
+    timer.reset();
+    if(profiling)prof.beginFrame();
+    replaySubmits(capture.submits,frame);
+    if(profiling)prof.endFrame();
+    time += timer.elapsedFromStart();
+  }
+
+  std::cout << "submissions per frame: " << capture.submits.size() << std::endl;
+  std::cout << "Seconds per frame: " << std::scientific << std::setprecision(10)
+            << time / static_cast<float>(nofReplays?nofReplays:1) << std::endl;
+
+  if(profiling)profiler::report(prof,printProfile,traceFile);
+
+  if(imageFile.empty())return;
+  framebuffer->resolve();
+  saveFramePNG(imageFile,framebuffer->color.data(),frame.width,frame.height);
+  std::cerr << "storing replayed frame to: \"" << imageFile << "\"" << std::endl;
+}
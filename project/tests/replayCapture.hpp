@@ -0,0 +1,6 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+void replayCapture(std::string const&captureFile,size_t nofReplays,bool printProfile = false,std::string const&traceFile = "",std::string const&imageFile = "");
@@ -2,6 +2,10 @@
 #include <framework/application.hpp>
 #include <SDL.h>
 
+#include <libs/stb_image/stb_image_write.h>
+
+#include <cstring>
+
 void saveFrame(std::string const&file,Frame const&frame){
   auto surface = SDL_CreateRGBSurface(0, frame.width, frame.height, 24,0,0,0,0);
 
@@ -12,3 +16,36 @@ void saveFrame(std::string const&file,Frame const&frame){
   SDL_FreeSurface(rgb);
   SDL_FreeSurface(surface);
 }
+
+/**
+ * @brief This function converts color buffer (RGBA8, bottom row first) into image (RGBA8, top row first, opaque).
+ * Rows are flipped by memcpy.
+ *
+ * @param image output image, it is resized
+ * @param color color buffer
+ * @param width width of color buffer
+ * @param height height of color buffer
+ */
+void frameToImage(std::vector<uint8_t>&image,uint8_t const*color,uint32_t width,uint32_t height){
+  size_t const rowSize = (size_t)width*4;
+  image.resize(rowSize*height);
+  for(uint32_t y=0;y<height;++y){
+    auto*dst = image.data()+(size_t)(height-1-y)*rowSize;
+    std::memcpy(dst,color+(size_t)y*rowSize,rowSize);
+    for(size_t a=3;a<rowSize;a+=4)dst[a] = 255;
+  }
+}
+
+/**
+ * @brief This function stores color buffer (RGBA8, bottom row first) into png file.
+ *
+ * @param file png file
+ * @param color color buffer
+ * @param width width of color buffer
+ * @param height height of color buffer
+ */
+void saveFramePNG(std::string const&file,uint8_t const*color,uint32_t width,uint32_t height){
+  std::vector<uint8_t>image;
+  frameToImage(image,color,width,height);
+  stbi_write_png(file.c_str(),width,height,4,image.data(),0);
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include<string>
+#include<vector>
 #include<student/fwd.hpp>
 
 void saveFrame(std::string const&file,Frame const&frame);
+
+void frameToImage(std::vector<uint8_t>&image,uint8_t const*color,uint32_t width,uint32_t height);
+void saveFramePNG(std::string const&file,uint8_t const*color,uint32_t width,uint32_t height);
@@ -1,9 +1,8 @@
 #include <tests/takeScreenShot.hpp>
 #include <tests/renderMethodFrame.hpp>
+#include <tests/saveFrame.hpp>
 #include <framework/application.hpp>
 
-#include <libs/stb_image/stb_image_write.h>
-
 #include <SDL.h>
 #include <string>
 
@@ -14,18 +13,7 @@ void takeScreenShot(std::string const&groundTruthFile){
 
   auto frame = renderMethodFrame(width,height);
 
-  for(uint32_t y=0;y<height/2;++y)
-    for(uint32_t x=0;x<width;++x){
-      for(uint32_t c=0;c<3;++c){
-        auto z=frame.at((y*width+x)*4+c);
-        frame.at((y*width+x)*4+c) = frame.at(((height-1-y)*width+x)*4+c);
-        frame.at(((height-1-y)*width+x)*4+c) = z;
-      }
-      frame.at(((         y)*width+x)*4+3)=255;
-      frame.at(((height-1-y)*width+x)*4+3)=255;
-    }
-
-  stbi_write_png(groundTruthFile.c_str(),width,height,4,frame.data(),0);
+  saveFramePNG(groundTruthFile,frame.data(),width,height);
 
   //auto surface = SDL_CreateRGBSurface(0, width, height, 24,0,0,0,0);
 
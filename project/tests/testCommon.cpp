@@ -145,6 +145,26 @@ template<>std::string str(AttributeType const&a){
     case AttributeType::UVEC2:return "AttributeType::UVEC2";
     case AttributeType::UVEC3:return "AttributeType::UVEC3";
     case AttributeType::UVEC4:return "AttributeType::UVEC4";
+    case AttributeType::SNORM8      :return "AttributeType::SNORM8"      ;
+    case AttributeType::SNORM8_VEC2 :return "AttributeType::SNORM8_VEC2" ;
+    case AttributeType::SNORM8_VEC3 :return "AttributeType::SNORM8_VEC3" ;
+    case AttributeType::SNORM8_VEC4 :return "AttributeType::SNORM8_VEC4" ;
+    case AttributeType::UNORM8      :return "AttributeType::UNORM8"      ;
+    case AttributeType::UNORM8_VEC2 :return "AttributeType::UNORM8_VEC2" ;
+    case AttributeType::UNORM8_VEC3 :return "AttributeType::UNORM8_VEC3" ;
+    case AttributeType::UNORM8_VEC4 :return "AttributeType::UNORM8_VEC4" ;
+    case AttributeType::SNORM16     :return "AttributeType::SNORM16"     ;
+    case AttributeType::SNORM16_VEC2:return "AttributeType::SNORM16_VEC2";
+    case AttributeType::SNORM16_VEC3:return "AttributeType::SNORM16_VEC3";
+    case AttributeType::SNORM16_VEC4:return "AttributeType::SNORM16_VEC4";
+    case AttributeType::UNORM16     :return "AttributeType::UNORM16"     ;
+    case AttributeType::UNORM16_VEC2:return "AttributeType::UNORM16_VEC2";
+    case AttributeType::UNORM16_VEC3:return "AttributeType::UNORM16_VEC3";
+    case AttributeType::UNORM16_VEC4:return "AttributeType::UNORM16_VEC4";
+    case AttributeType::HALF        :return "AttributeType::HALF"        ;
+    case AttributeType::HALF_VEC2   :return "AttributeType::HALF_VEC2"   ;
+    case AttributeType::HALF_VEC3   :return "AttributeType::HALF_VEC3"   ;
+    case AttributeType::HALF_VEC4   :return "AttributeType::HALF_VEC4"   ;
     default: return "unknown";
   }
 }
@@ -0,0 +1,204 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <iostream>
+#include <vector>
+
+#include <student/gpu.hpp>
+#include <framework/textureResidency.hpp>
+#include <tests/testCommon.hpp>
+
+using namespace tests;
+
+namespace textureResidencyTests{
+
+uint32_t const size        = 256;
+uint32_t const channels    = 4;
+uint32_t const nofTextures = 3;
+uint32_t const tailLevel   = 3;///< 32x32
+
+uint8_t texel(uint32_t texture,uint32_t x,uint32_t y,uint32_t c){
+  return (uint8_t)(x + 3*y + 50*c + 20*texture);
+}
+
+/**
+ * @brief This function creates sources of textures with known texels, they count their loads.
+ */
+std::vector<TextureSource>createSources(std::vector<uint32_t>&nofLoads){
+  std::vector<TextureSource>res(nofTextures);
+  nofLoads.assign(nofTextures,0);
+  for(uint32_t t=0;t<nofTextures;++t){
+    auto&s    = res[t];
+    s.width    = size;
+    s.height   = size;
+    s.channels = channels;
+    s.load     = [t,&nofLoads](std::vector<uint8_t>&pixels){
+      nofLoads[t]++;
+      pixels.resize((size_t)size*size*channels);
+      for(uint32_t y=0;y<size;++y)
+        for(uint32_t x=0;x<size;++x)
+          for(uint32_t c=0;c<channels;++c)
+            pixels[((size_t)y*size+x)*channels+c] = texel(t,x,y,c);
+      return true;
+    };
+  }
+  return res;
+}
+
+uint64_t levelSize(uint32_t level){
+  return (uint64_t)(size>>level)*(size>>level)*channels;
+}
+
+/**
+ * @brief This function samples textures by read_texture without footprint (it marks them as sampled).
+ */
+void sample(TextureResidency const&residency,std::vector<uint32_t>const&textures){
+  ResidentTextures resident;
+  residency.getTextures(resident);
+  for(auto const t:textures)read_texture(resident.textures.at(t),glm::vec2(.5f));
+}
+
+/**
+ * @brief This function samples texture by read_texture with footprint (it requests mip level by sampling feedback).
+ *
+ * @param texels size of footprint in texels of level 0
+ */
+void sampleFootprint(TextureResidency const&residency,uint32_t texture,float texels){
+  ResidentTextures resident;
+  residency.getTextures(resident);
+  read_texture(resident.textures.at(texture),glm::vec2(.5f),glm::vec2(texels/size,0.f),glm::vec2(0.f,.5f/size));
+}
+
+/**
+ * @brief This function checks resident levels of all textures.
+ *
+ * @return true if they are equal to expected levels
+ */
+bool checkLevels(TextureResidency const&residency,std::vector<uint32_t>const&expected,std::string const&step){
+  std::vector<uint32_t>levels;
+  for(uint32_t t=0;t<nofTextures;++t)levels.push_back(residency.getLevel(t));
+  if(levels == expected)return true;
+  std::cerr << R".(
+  TEST SELHAL!
+
+  Tento test ověřuje správu rezidentních mip úrovní textur (TextureResidency).
+  Požadovaná úroveň se musí stát rezidentní při následujícím update().
+  Úroveň vypočtená funkcí read_texture se stopou (footprint) je také požadavkem.
+  Pokud se požadované úrovně nevejdou do rozpočtu, zhrubnou nejdříve textury,
+  které read_texture četla nejdávněji (LRU).
+  Správce s lokálními snímky (frameLocal) volí úrovně jen z požadavků od posledního update().
+  )." << std::endl;
+  std::cerr << "  krok: " << step << std::endl;
+  std::cerr << "  úrovně textur:";
+  for(auto const l:levels  )std::cerr << " " << l;
+  std::cerr << std::endl << "  očekáváno   :";
+  for(auto const l:expected)std::cerr << " " << l;
+  std::cerr << std::endl;
+  return false;
+}
+
+}
+
+using namespace textureResidencyTests;
+
+SCENARIO("51"){
+  std::cerr << "51 - texture residency - requested levels and LRU eviction" << std::endl;
+
+  // two full resolution textures and one mip tail fit into the budget
+  std::vector<uint32_t>nofLoads;
+  TextureResidency residency;
+  residency.init(createSources(nofLoads),2*levelSize(0)+levelSize(tailLevel));
+
+  REQUIRE(checkLevels(residency,{tailLevel,tailLevel,tailLevel},"po init() jsou rezidentní pouze mip tail"));
+  REQUIRE(residency.getResidentSize() == nofTextures*levelSize(tailLevel));
+
+  // request is fulfilled without sampling feedback
+  residency.request(0,1);
+  REQUIRE(residency.update() == true);
+  REQUIRE(checkLevels(residency,{1,tailLevel,tailLevel},"požadavek úrovně 1 textury 0"));
+  REQUIRE(residency.getResidentSize() == levelSize(1)+2*levelSize(tailLevel));
+
+  residency.request(0,1);
+  REQUIRE(residency.update() == false);
+
+  // textures 1 and 2 are sampled, texture 0 is the least recently used one
+  sample(residency,{1,2});
+  for(uint32_t t=0;t<nofTextures;++t)residency.request(t,0);
+  REQUIRE(residency.update() == true);
+  REQUIRE(checkLevels(residency,{tailLevel,0,0},"textury 1 a 2 byly čteny, všechny chtějí úroveň 0"));
+  REQUIRE(residency.getResidentSize() <= 2*levelSize(0)+levelSize(tailLevel));
+
+  ResidentTextures resident;
+  residency.getTextures(resident);
+  auto const&full = resident.textures.at(1);
+  REQUIRE(full.width  == size);
+  REQUIRE(full.height == size);
+  REQUIRE(full.data[((size_t)7*size+5)*channels+2] == texel(1,5,7,2));
+  // coarser level is built from the resident level, the source is not read
+  auto const loadsBefore = nofLoads[1];
+
+  // textures 0 and 2 are sampled, texture 1 is the least recently used one
+  sample(residency,{0,2});
+  for(uint32_t t=0;t<nofTextures;++t)residency.request(t,0);
+  REQUIRE(residency.update() == true);
+  REQUIRE(checkLevels(residency,{0,tailLevel,0},"textury 0 a 2 byly čteny, všechny chtějí úroveň 0"));
+  REQUIRE(nofLoads[1] == loadsBefore);
+
+  // pixels of the previous frame stay valid after update
+  REQUIRE(full.data[((size_t)7*size+5)*channels+2] == texel(1,5,7,2));
+
+  ResidentTextures current;
+  residency.getTextures(current);
+  REQUIRE(current.textures.at(1).width == (size>>tailLevel));
+  REQUIRE(current.textures.at(0).data[((size_t)9*size+4)*channels] == texel(0,4,9,0));
+}
+
+SCENARIO("54"){
+  std::cerr << "54 - texture residency - sampling feedback and frame local levels" << std::endl;
+
+  std::vector<uint32_t>nofLoads;
+  TextureResidency residency;
+  residency.init(createSources(nofLoads),nofTextures*levelSize(0));
+
+  // footprint of 4 texels of level 0 needs level 2, the finest footprint wins
+  sampleFootprint(residency,0,4.f);
+  sampleFootprint(residency,0,16.f);
+  sampleFootprint(residency,1,.5f);
+  REQUIRE(residency.update() == true);
+  REQUIRE(checkLevels(residency,{2,0,tailLevel},"read_texture se stopou 4 texely (textura 0) a 0.5 texelu (textura 1)"));
+
+  ResidentTextures resident;
+  residency.getTextures(resident);
+  REQUIRE(resident.textures.at(0).level == 2);
+  REQUIRE(resident.textures.at(0).width == (size>>2));
+
+  // sampling without footprint does not change levels
+  sample(residency,{0,1,2});
+  REQUIRE(residency.update() == false);
+  REQUIRE(checkLevels(residency,{2,0,tailLevel},"read_texture bez stopy"));
+
+  // frame local manager shares levels of the other manager, it does not read the sources
+  auto const loadsBefore = nofLoads;
+  TextureResidency local;
+  local.init(residency,levelSize(0)+2*levelSize(tailLevel),true);
+  REQUIRE(nofLoads == loadsBefore);
+  REQUIRE(checkLevels(local,{2,0,tailLevel},"init() z jiného správce"));
+
+  // textures without request fall back to mip tails, feedback is ignored
+  sampleFootprint(local,2,1.f);
+  local.request(0,1);
+  REQUIRE(local.update() == true);
+  REQUIRE(checkLevels(local,{1,tailLevel,tailLevel},"lokální snímek - požadavek úrovně 1 textury 0"));
+
+  // textures are coarsened in order of their indices, not by history
+  sample(local,{1});
+  local.request(0,0);
+  local.request(1,0);
+  REQUIRE(local.update() == true);
+  REQUIRE(checkLevels(local,{tailLevel,0,tailLevel},"lokální snímek - textury 0 a 1 chtějí úroveň 0"));
+
+  REQUIRE(local.update() == true);
+  REQUIRE(checkLevels(local,{tailLevel,tailLevel,tailLevel},"lokální snímek bez požadavků"));
+
+  // the other manager is not changed
+  REQUIRE(checkLevels(residency,{2,0,tailLevel},"původní správce"));
+}
@@ -1,9 +1,11 @@
 #include <iostream>
 
 #include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include <tests/testCommon.hpp>
 #include <tests/modelTestUtils.hpp>
+#include <student/sceneGraph.hpp>
 
 using namespace tests;
 using namespace tests::model;
@@ -227,3 +229,72 @@ SCENARIO("31"){
   #undef MESHES
 }
 
+
+SCENARIO("53"){
+  std::cerr << "53 - scene graph - world matrices and update of subtree" << std::endl;
+
+  auto const equalMatrices = [](glm::mat4 const&a,glm::mat4 const&b){
+    for(int i=0;i<4;++i)
+      if(!equalVec4(a[i],b[i]))return false;
+    return true;
+  };
+
+  auto const A = glm::translate(glm::mat4(1.f),glm::vec3(1.f,0.f,0.f));
+  auto const B = glm::translate(glm::mat4(1.f),glm::vec3(0.f,2.f,0.f));
+  auto const C = glm::scale    (glm::mat4(1.f),glm::vec3(2.f));
+  auto const D = glm::rotate   (glm::mat4(1.f),1.f,glm::vec3(0.f,0.f,1.f));
+  auto const E = glm::translate(glm::mat4(1.f),glm::vec3(0.f,0.f,3.f));
+
+  // pre-order: 0 A, 1 B, 2 C, 3 D, 4 E
+  auto const nc = NodeI(0,{},C);
+  auto const nb = NodeI(-1,{nc},B);
+  auto const nd = NodeI(1,{},D);
+  auto const na = NodeI(-1,{nb,nd},A);
+  auto const ne = NodeI(2,{},E);
+  auto model = createModel({3,6,9},std::vector<NodeI>{na,ne});
+
+  SceneGraph scene(model.roots);
+  std::vector<glm::mat4>expected = {A,A*B,A*B*C,A*D,E};
+  std::vector<int32_t  >parents  = {-1,0,1,0,-1};
+  std::vector<int32_t  >meshes   = {-1,-1,0,1,2};
+
+  std::string step = "po sestavení";
+  auto const check = [&](){
+    auto const&nodes = scene.getNodes();
+    bool wrong = nodes.size() != expected.size();
+    for(size_t i=0;i<nodes.size() && !wrong;++i)
+      wrong = nodes[i].parent != parents[i] || nodes[i].mesh != meshes[i] || !equalMatrices(nodes[i].worldMatrix,expected[i]);
+    if(!wrong)return true;
+    std::cerr << R".(
+    TEST SELHAL!
+
+    Tento test ověřuje zploštělý graf scény (SceneGraph).
+    Uzly jsou uloženy v pre-order, světová matice uzlu je světová matice rodiče krát lokální matice uzlu.
+    Po změně lokální matice (setLocalMatrix) musí update() přepočítat celý podstrom uzlu.
+    )." << std::endl;
+    std::cerr << "    krok: " << step << std::endl;
+    for(size_t i=0;i<nodes.size();++i){
+      std::cerr << "    uzel " << i << " rodič: " << nodes[i].parent << " mesh: " << nodes[i].mesh << std::endl;
+      std::cerr << "      světová matice: " << str(nodes[i].worldMatrix) << std::endl;
+      if(i < expected.size())std::cerr << "      očekáváno   : " << str(expected[i]) << std::endl;
+    }
+    return false;
+  };
+  REQUIRE(check());
+
+  auto const B2 = glm::translate(glm::mat4(1.f),glm::vec3(0.f,-5.f,0.f));
+  scene.setLocalMatrix(1,B2);
+  scene.setLocalMatrix(2,C*C);
+  REQUIRE(scene.update() == true);
+  expected[1] = A*B2;
+  expected[2] = A*B2*C*C;
+  step = "po změně lokálních matic uzlů 1 a 2";
+  REQUIRE(check());
+  REQUIRE(scene.update() == false);
+
+  // draws use world matrices of the updated graph
+  MEMCB();
+  prepareModel(mem,cb,model,scene);
+  REQUIRE(equalMatrices(mem.uniforms[drawModelUniforms(0)+DrawModelUniform::MODEL].m4,expected[2]));
+  REQUIRE(equalMatrices(mem.uniforms[drawModelUniforms(2)+DrawModelUniform::MODEL].m4,expected[4]));
+}